@@ -0,0 +1,63 @@
+#ifndef ATOMIC_HPP_INCLUDED
+#define ATOMIC_HPP_INCLUDED
+
+// Minimal atomics for the lock-free parts of the engine: full
+// barriers, acquire/release word access and pointer CAS. GCC builtins
+// on Linux, Interlocked functions on Windows.
+
+#ifdef _WIN32
+#include <windows.h>
+
+static inline void
+atomic_fence(void)
+{
+	MemoryBarrier();
+}
+
+static inline bool
+atomic_cas_ptr(void *volatile *target, void *expected, void *desired)
+{
+	return InterlockedCompareExchangePointer(target, desired, expected) == expected;
+}
+#else
+
+static inline void
+atomic_fence(void)
+{
+	__sync_synchronize();
+}
+
+static inline bool
+atomic_cas_ptr(void *volatile *target, void *expected, void *desired)
+{
+	return __sync_bool_compare_and_swap(target, expected, desired);
+}
+#endif
+
+// x86 keeps loads and stores in order, so acquire/release only has
+// to stop the compiler from reordering; elsewhere use a full fence.
+#if defined(_MSC_VER)
+#define ATOMIC_ORDER() _ReadWriteBarrier()
+#elif defined(__i386__) || defined(__x86_64__)
+#define ATOMIC_ORDER() __asm__ __volatile__("" ::: "memory")
+#else
+#define ATOMIC_ORDER() atomic_fence()
+#endif
+
+// Aligned word loads and stores are atomic on the targets we build for
+static inline unsigned int
+atomic_load_acquire(const volatile unsigned int *value)
+{
+	unsigned int v = *value;
+	ATOMIC_ORDER();
+	return v;
+}
+
+static inline void
+atomic_store_release(volatile unsigned int *value, unsigned int v)
+{
+	ATOMIC_ORDER();
+	*value = v;
+}
+
+#endif // ATOMIC_HPP_INCLUDED
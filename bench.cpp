@@ -0,0 +1,458 @@
+#include "bench.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <GL/gl.h>
+
+#include "fps.hpp"
+#include "keyboard.hpp"
+#include "cull.hpp"
+#include "mesh.hpp"
+#include "replay.hpp"
+#include "latency.hpp"
+#include "overdraw.hpp"
+#include "memory.hpp"
+#include "profile.hpp"
+#include "glstats.hpp"
+#include "headless.hpp"
+#include "scene.hpp"
+#include "particle.hpp"
+#include "dynres.hpp"
+#include "quality.hpp"
+#include "spatial.hpp"
+
+// Scripted input, looped for as long as the benchmark runs
+struct BenchStep
+{
+	int          frames;
+	unsigned int buttons; // (1 << BTN_*) mask
+};
+
+static const BenchStep script[] = {
+	{ 60, 1 << BTN_RIGHT },
+	{ 60, 1 << BTN_UP },
+	{ 60, 1 << BTN_LEFT },
+	{ 60, 1 << BTN_DOWN },
+	{ 30, 1 << BTN_ACTION2 },
+	{ 30, 1 << BTN_ACTION1 },
+	{ 30, 0 },
+};
+
+static const int num_steps = sizeof(script) / sizeof(BenchStep);
+
+static BenchOptions opts;
+static double      *frame_times  = NULL;
+static int          num_frames   = 0;
+static double       frame_start  = 0.0;
+static unsigned int held_buttons = 0;
+static double       sum_visible  = 0.0;
+static double       sum_culled   = 0.0;
+static double       sum_triangles = 0.0;
+static double       sum_gl[6 + GLSTATS_PRIMITIVES];
+static double       sum_overdraw = 0.0;
+static double       sum_overdraw_covered = 0.0;
+static int          max_overdraw = 0;
+static double       sum_allocs   = 0.0;
+static double       sum_alloc_bytes = 0.0;
+static double       sum_particles = 0.0;
+static double       sum_zone_ms[PROFILE_MAX_ZONES];
+
+void
+bench_default_options(BenchOptions *options)
+{
+	options->frames = 600;
+	options->warmup = 30;
+	options->width  = 500;
+	options->height = 500;
+	options->output = NULL;
+}
+
+
+bool
+bench_init(const BenchOptions *options)
+{
+	opts = *options;
+
+	if(!headless_create(opts.width, opts.height))
+		return false;
+
+	frame_times = (double*)malloc(opts.frames * sizeof(double));
+	num_frames = 0;
+	held_buttons = 0;
+	sum_visible = sum_culled = sum_triangles = 0.0;
+	memset(sum_gl, 0, sizeof(sum_gl));
+	sum_overdraw = sum_overdraw_covered = 0.0;
+	max_overdraw = 0;
+	sum_allocs = sum_alloc_bytes = sum_particles = 0.0;
+	memset(sum_zone_ms, 0, sizeof(sum_zone_ms));
+
+	// Simulate at a fixed 60Hz so every run sees the same states;
+	// a recording brings its own rate
+	if(!replay_active())
+		fpsSetFixedStep(1.0 / 60.0);
+	return true;
+}
+
+void
+bench_frame_begin(int frame)
+{
+	frame_start = getElapsedTime();
+
+	// A recording takes the place of the built-in script
+	if(replay_active())
+		return;
+
+	int script_length = 0;
+	for(int i = 0; i < num_steps; i++)
+		script_length += script[i].frames;
+
+	int t = frame % script_length;
+	int step = 0;
+	while(t >= script[step].frames) {
+		t -= script[step].frames;
+		step++;
+	}
+
+	unsigned int buttons = script[step].buttons;
+	unsigned int changed = buttons ^ held_buttons;
+	for(unsigned int b = 0; changed; b++, changed >>= 1) {
+		if(changed & 1)
+			kbdUpdateButton(b, (buttons >> b) & 1);
+	}
+	held_buttons = buttons;
+}
+
+void
+bench_frame_end(void)
+{
+	// Wait for the rasterizer so frame times include GL work
+	glFinish();
+	double elapsed = getElapsedTime() - frame_start;
+
+	if(num_frames >= opts.frames)
+		return;
+
+	frame_times[num_frames++] = elapsed * 1000.0;
+
+	if(num_frames > opts.warmup) {
+		CullStats cull;
+		cull_get_stats(&cull);
+		sum_visible += cull.visible;
+		sum_culled += cull.culled;
+		sum_triangles += mesh_triangles_submitted();
+		sum_particles += scene_particles_live();
+
+		GLStats gl;
+		glstats_last(&gl);
+		sum_gl[0] += gl.calls;
+		sum_gl[1] += gl.draw_calls;
+		sum_gl[2] += gl.state_changes;
+		sum_gl[3] += gl.texture_binds;
+		sum_gl[4] += gl.matrix_loads;
+		sum_gl[5] += gl.bytes_uploaded;
+		for(int i = 0; i < GLSTATS_PRIMITIVES; i++)
+			sum_gl[6 + i] += gl.vertices[i];
+
+		OverdrawStats overdraw;
+		overdraw_last(&overdraw);
+		sum_overdraw += overdraw.average;
+		sum_overdraw_covered += overdraw.average_covered;
+		if(overdraw.max > max_overdraw)
+			max_overdraw = overdraw.max;
+
+		MemStats mem;
+		mem_last(&mem);
+		sum_allocs += mem.allocs;
+		sum_alloc_bytes += mem.bytes_allocated;
+
+		const ProfileZoneStats *zones;
+		int num_zones = profile_last(&zones);
+		for(int i = 0; i < num_zones; i++)
+			sum_zone_ms[i] += zones[i].ms;
+	}
+}
+
+static int
+_compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static double
+_percentile(const double *sorted, int count, double p)
+{
+	int rank = (int)ceil(p / 100.0 * count) - 1;
+	if(rank < 0)
+		rank = 0;
+	if(rank >= count)
+		rank = count - 1;
+	return sorted[rank];
+}
+
+void
+bench_report(void)
+{
+	int warmup = opts.warmup < num_frames ? opts.warmup : 0;
+	int count = num_frames - warmup;
+	double *times = frame_times + warmup;
+	double total = 0.0, variance = 0.0;
+
+	if(count <= 0) {
+		fprintf(stderr, "bench: no frames measured\n");
+		return;
+	}
+
+	for(int i = 0; i < count; i++)
+		total += times[i];
+	double mean = total / count;
+	for(int i = 0; i < count; i++)
+		variance += (times[i] - mean) * (times[i] - mean);
+
+	qsort(times, count, sizeof(double), _compare_doubles);
+
+	FILE *out = opts.output ? fopen(opts.output, "w") : stdout;
+	if(!out) {
+		fprintf(stderr, "bench: cannot open %s\n", opts.output);
+		return;
+	}
+
+	const char *renderer = (const char*)glGetString(GL_RENDERER);
+
+	fprintf(out, "{\n");
+	fprintf(out, "  \"renderer\": \"%s\",\n", renderer ? renderer : "unknown");
+	fprintf(out, "  \"width\": %d,\n", opts.width);
+	fprintf(out, "  \"height\": %d,\n", opts.height);
+	fprintf(out, "  \"particle_path\": \"%s\",\n", particle_sprites() ? "sprites" : "quads");
+	fprintf(out, "  \"frames\": %d,\n", count);
+	fprintf(out, "  \"warmup\": %d,\n", warmup);
+	fprintf(out, "  \"total_ms\": %.3f,\n", total);
+	fprintf(out, "  \"fps\": %.2f,\n", 1000.0 / mean);
+	fprintf(out, "  \"frame_ms\": {\n");
+	fprintf(out, "    \"min\": %.4f,\n", times[0]);
+	fprintf(out, "    \"mean\": %.4f,\n", mean);
+	fprintf(out, "    \"stddev\": %.4f,\n", sqrt(variance / count));
+	fprintf(out, "    \"p50\": %.4f,\n", _percentile(times, count, 50.0));
+	fprintf(out, "    \"p90\": %.4f,\n", _percentile(times, count, 90.0));
+	fprintf(out, "    \"p99\": %.4f,\n", _percentile(times, count, 99.0));
+	fprintf(out, "    \"max\": %.4f\n", times[count - 1]);
+	fprintf(out, "  },\n");
+	fprintf(out, "  \"per_frame\": {\n");
+	fprintf(out, "    \"visible\": %.2f,\n", sum_visible / count);
+	fprintf(out, "    \"culled\": %.2f,\n", sum_culled / count);
+	fprintf(out, "    \"mesh_triangles\": %.1f,\n", sum_triangles / count);
+	fprintf(out, "    \"particles\": %.1f,\n", sum_particles / count);
+	fprintf(out, "    \"allocs\": %.2f,\n", sum_allocs / count);
+	fprintf(out, "    \"alloc_bytes\": %.1f\n", sum_alloc_bytes / count);
+	fprintf(out, "  },\n");
+
+	const ProfileZoneStats *zones;
+	int num_zones = profile_last(&zones);
+	fprintf(out, "  \"zone_ms\": {");
+	for(int i = 0; i < num_zones; i++) {
+		fprintf(out, "%s\n    \"%s\": %.4f", i ? "," : "",
+		        zones[i].name, sum_zone_ms[i] / count);
+	}
+	fprintf(out, "%s}", num_zones ? "\n  " : "");
+	if(glstats_enabled()) {
+		fprintf(out, ",\n  \"gl_per_frame\": {\n");
+		fprintf(out, "    \"calls\": %.1f,\n", sum_gl[0] / count);
+		fprintf(out, "    \"draw_calls\": %.1f,\n", sum_gl[1] / count);
+		fprintf(out, "    \"state_changes\": %.1f,\n", sum_gl[2] / count);
+		fprintf(out, "    \"texture_binds\": %.1f,\n", sum_gl[3] / count);
+		fprintf(out, "    \"matrix_loads\": %.1f,\n", sum_gl[4] / count);
+		fprintf(out, "    \"bytes_uploaded\": %.1f,\n", sum_gl[5] / count);
+		fprintf(out, "    \"vertices\": {");
+		bool first = true;
+		for(int i = 0; i < GLSTATS_PRIMITIVES; i++) {
+			if(sum_gl[6 + i] == 0.0)
+				continue;
+			fprintf(out, "%s \"%s\": %.1f", first ? "" : ",",
+			        glstats_primitive_name(i), sum_gl[6 + i] / count);
+			first = false;
+		}
+		fprintf(out, " }\n  }");
+	}
+	if(overdraw_enabled()) {
+		fprintf(out, ",\n  \"overdraw\": {\n");
+		fprintf(out, "    \"average\": %.3f,\n", sum_overdraw / count);
+		fprintf(out, "    \"average_covered\": %.3f,\n", sum_overdraw_covered / count);
+		fprintf(out, "    \"max\": %d\n", max_overdraw);
+		fprintf(out, "  }");
+	}
+	if(dynres_enabled()) {
+		DynresStats dynres;
+		dynres_stats(&dynres);
+		fprintf(out, ",\n  \"dynres\": {\n");
+		fprintf(out, "    \"budget_ms\": %.2f,\n", dynres.budget_ms);
+		fprintf(out, "    \"scale\": %.3f,\n", dynres.scale);
+		fprintf(out, "    \"average_scale\": %.3f,\n", dynres.average_scale);
+		fprintf(out, "    \"min_scale\": %.3f,\n", dynres.min_scale);
+		fprintf(out, "    \"max_scale\": %.3f,\n", dynres.max_scale);
+		fprintf(out, "    \"changes\": %u\n", dynres.changes);
+		fprintf(out, "  }");
+	}
+	if(quality_enabled()) {
+		fprintf(out, ",\n  \"quality\": ");
+		quality_write_json(out, "  ");
+	}
+	if(latency_enabled()) {
+		fprintf(out, ",\n  \"latency\": ");
+		latency_write_json(out, "  ");
+	}
+	fprintf(out, "\n");
+	fprintf(out, "}\n");
+
+	if(out != stdout)
+		fclose(out);
+}
+
+void
+bench_dispose(void)
+{
+	free(frame_times);
+	frame_times = NULL;
+	fpsSetFixedStep(0.0);
+
+	headless_destroy();
+}
+
+// Pairs as a count and an order independent checksum
+struct SpatialTally
+{
+	int          pairs;
+	unsigned int sum;
+};
+
+static void
+_tally_pair(int a, int b, void *data)
+{
+	SpatialTally *tally = (SpatialTally*)data;
+	tally->pairs++;
+	tally->sum += (unsigned int)a * 2654435761u ^ (unsigned int)b;
+}
+
+// Same seed every run. Density does not depend on the count, about one
+// body per 4 cells, and one body in 16 spans several cells.
+static void
+_spatial_bodies(SpatialBox *boxes, int count)
+{
+	unsigned int seed = 12345;
+	float side = 2.0f * sqrtf((float)count);
+	for(int i = 0; i < count; i++) {
+		float r[3];
+		for(int k = 0; k < 3; k++) {
+			seed = seed * 1103515245u + 12345u;
+			r[k] = (seed >> 8) / 16777216.0f;
+		}
+		float half = (i & 15) ? 0.05f + 0.2f * r[2] : 0.5f + r[2];
+		boxes[i].minx = r[0] * side - half;
+		boxes[i].maxx = r[0] * side + half;
+		boxes[i].miny = r[1] * side - half;
+		boxes[i].maxy = r[1] * side + half;
+	}
+}
+
+static void
+_spatial_brute(const SpatialBox *boxes, int count, SpatialTally *tally)
+{
+	for(int i = 0; i < count; i++) {
+		const SpatialBox &a = boxes[i];
+		for(int j = i + 1; j < count; j++) {
+			const SpatialBox &b = boxes[j];
+			if(a.minx <= b.maxx && b.minx <= a.maxx
+			   && a.miny <= b.maxy && b.miny <= a.maxy)
+				_tally_pair(i, j, tally);
+		}
+	}
+}
+
+static void
+_write_times(FILE *out, const char *name, double *times, int count, bool last)
+{
+	double total = 0.0;
+	for(int i = 0; i < count; i++)
+		total += times[i];
+	qsort(times, count, sizeof(double), _compare_doubles);
+
+	fprintf(out, "  \"%s\": {\n", name);
+	fprintf(out, "    \"min\": %.4f,\n", times[0]);
+	fprintf(out, "    \"mean\": %.4f,\n", total / count);
+	fprintf(out, "    \"p50\": %.4f,\n", _percentile(times, count, 50.0));
+	fprintf(out, "    \"p90\": %.4f,\n", _percentile(times, count, 90.0));
+	fprintf(out, "    \"max\": %.4f\n", times[count - 1]);
+	fprintf(out, "  }%s\n", last ? "" : ",");
+}
+
+// Brute force is quadratic, bigger sets are only timed
+#define BENCH_SPATIAL_CHECK_MAX 20000
+
+int
+bench_spatial(int bodies, const BenchOptions *options)
+{
+	int warmup = options->warmup < options->frames ? options->warmup : 0;
+	int count = options->frames - warmup;
+	if(bodies <= 0 || count <= 0) {
+		fprintf(stderr, "bench: no bodies or no frames measured\n");
+		return 1;
+	}
+
+	SpatialBox *boxes = (SpatialBox*)malloc(bodies * sizeof(SpatialBox));
+	double *build_ms = (double*)malloc(count * sizeof(double));
+	double *pairs_ms = (double*)malloc(count * sizeof(double));
+	_spatial_bodies(boxes, bodies);
+	spatial_init(1.0f, bodies);
+
+	SpatialTally tally;
+	for(int i = 0; i < options->frames; i++) {
+		double start = getElapsedTime();
+		spatial_build(boxes, bodies);
+		double built = getElapsedTime();
+		tally.pairs = 0;
+		tally.sum = 0;
+		spatial_pairs(_tally_pair, &tally);
+		double done = getElapsedTime();
+		if(i >= warmup) {
+			build_ms[i - warmup] = (built - start) * 1000.0;
+			pairs_ms[i - warmup] = (done - built) * 1000.0;
+		}
+	}
+
+	bool checked = bodies <= BENCH_SPATIAL_CHECK_MAX;
+	bool match = true;
+	SpatialTally brute = tally;
+	if(checked) {
+		brute.pairs = 0;
+		brute.sum = 0;
+		_spatial_brute(boxes, bodies, &brute);
+		match = brute.pairs == tally.pairs && brute.sum == tally.sum;
+		if(!match)
+			fprintf(stderr, "bench: %d pairs, brute force finds %d\n",
+			        tally.pairs, brute.pairs);
+	}
+
+	FILE *out = options->output ? fopen(options->output, "w") : stdout;
+	if(out) {
+		fprintf(out, "{\n");
+		fprintf(out, "  \"bodies\": %d,\n", bodies);
+		fprintf(out, "  \"frames\": %d,\n", count);
+		fprintf(out, "  \"warmup\": %d,\n", warmup);
+		fprintf(out, "  \"pairs\": %d,\n", tally.pairs);
+		fprintf(out, "  \"brute_force\": %s,\n",
+		        checked ? (match ? "\"match\"" : "\"mismatch\"") : "null");
+		_write_times(out, "build_ms", build_ms, count, false);
+		_write_times(out, "pairs_ms", pairs_ms, count, true);
+		fprintf(out, "}\n");
+		if(out != stdout)
+			fclose(out);
+	} else {
+		fprintf(stderr, "bench: cannot open %s\n", options->output);
+	}
+
+	spatial_dispose();
+	free(pairs_ms);
+	free(build_ms);
+	free(boxes);
+	return match ? 0 : 1;
+}
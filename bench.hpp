@@ -0,0 +1,29 @@
+#ifndef BENCH_HPP_INCLUDED
+#define BENCH_HPP_INCLUDED
+
+// Headless benchmark mode. Renders into an offscreen EGL pbuffer
+// (surfaceless Mesa, no X server needed), drives the scene with a
+// scripted input sequence and writes frame time stats as JSON.
+
+struct BenchOptions
+{
+	int         frames;
+	int         warmup;
+	int         width;
+	int         height;
+	const char *output; // NULL for stdout
+};
+
+void bench_default_options(BenchOptions *options);
+bool bench_init(const BenchOptions *options);
+void bench_frame_begin(int frame);
+void bench_frame_end(void);
+void bench_report(void);
+void bench_dispose(void);
+
+// Collision broadphase alone, no GL: spatial_build and spatial_pairs
+// over a fixed pseudo-random set of bodies, once per frame, with the
+// pairs checked against brute force. Returns non-zero on a mismatch.
+int  bench_spatial(int bodies, const BenchOptions *options);
+
+#endif // BENCH_HPP_INCLUDED
@@ -0,0 +1,154 @@
+#include "cull.hpp"
+#include <cmath>
+#include <GL/gl.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define CULL_SSE
+#endif
+
+// Planes as (nx, ny, nz, d), normals pointing inside
+static float planes[6][4];
+static float abs_normals[6][3];
+
+static CullStats frame_stats;
+static CullStats last_stats;
+
+static void
+_mat_mul(float *out, const float *a, const float *b)
+{
+	for(int c = 0; c < 4; c++)
+		for(int r = 0; r < 4; r++)
+			out[c * 4 + r] =
+				a[r] * b[c * 4] + a[4 + r] * b[c * 4 + 1] +
+				a[8 + r] * b[c * 4 + 2] + a[12 + r] * b[c * 4 + 3];
+}
+
+void
+cull_begin_frame(void)
+{
+	float proj[16], view[16], clip[16];
+
+	frame_stats.visible = frame_stats.culled = 0;
+
+	glGetFloatv(GL_PROJECTION_MATRIX, proj);
+	glGetFloatv(GL_MODELVIEW_MATRIX, view);
+	_mat_mul(clip, proj, view);
+	cull_set_frustum(clip);
+}
+
+void
+cull_end_frame(void)
+{
+	last_stats = frame_stats;
+}
+
+void
+cull_set_frustum(const float *clip)
+{
+	// Gribb/Hartmann: each plane is the last row of the
+	// clip matrix plus or minus one of the other rows.
+	for(int i = 0; i < 6; i++) {
+		int row = i / 2;
+		float sign = (i & 1) ? -1.0f : 1.0f;
+		for(int j = 0; j < 4; j++)
+			planes[i][j] = clip[j * 4 + 3] + sign * clip[j * 4 + row];
+
+		float len = sqrtf(planes[i][0] * planes[i][0] +
+		                  planes[i][1] * planes[i][1] +
+		                  planes[i][2] * planes[i][2]);
+		if(len > 0.0f) {
+			for(int j = 0; j < 4; j++)
+				planes[i][j] /= len;
+		}
+
+		for(int j = 0; j < 3; j++)
+			abs_normals[i][j] = fabs(planes[i][j]);
+	}
+}
+
+// Shared by spheres and boxes: a volume is visible when its
+// center is no further than `reach` behind every plane.
+static int
+_cull(const float *x, const float *y, const float *z,
+      const float *rx, const float *ry, const float *rz,
+      int count, unsigned char *visible)
+{
+	int num_visible = 0;
+	int i = 0;
+
+#ifdef CULL_SSE
+	for(; i + 4 <= count; i += 4) {
+		__m128 cx = _mm_loadu_ps(x + i);
+		__m128 cy = _mm_loadu_ps(y + i);
+		__m128 cz = _mm_loadu_ps(z + i);
+		__m128 ex = _mm_loadu_ps(rx + i);
+		__m128 ey = ry ? _mm_loadu_ps(ry + i) : ex;
+		__m128 ez = rz ? _mm_loadu_ps(rz + i) : ex;
+		__m128 inside = _mm_cmpeq_ps(cx, cx);
+
+		for(int p = 0; p < 6; p++) {
+			__m128 dist = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(planes[p][0])),
+				           _mm_mul_ps(cy, _mm_set1_ps(planes[p][1]))),
+				_mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(planes[p][2])),
+				           _mm_set1_ps(planes[p][3])));
+			__m128 reach;
+			if(ry) {
+				reach = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(abs_normals[p][0])),
+					           _mm_mul_ps(ey, _mm_set1_ps(abs_normals[p][1]))),
+					_mm_mul_ps(ez, _mm_set1_ps(abs_normals[p][2])));
+			} else reach = ex;
+			inside = _mm_and_ps(inside,
+				_mm_cmpge_ps(_mm_add_ps(dist, reach), _mm_setzero_ps()));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for(int k = 0; k < 4; k++) {
+			visible[i + k] = (mask >> k) & 1;
+			num_visible += visible[i + k];
+		}
+	}
+#endif
+
+	for(; i < count; i++) {
+		bool inside = true;
+		for(int p = 0; p < 6 && inside; p++) {
+			float dist = planes[p][0] * x[i] + planes[p][1] * y[i]
+				+ planes[p][2] * z[i] + planes[p][3];
+			float reach = ry
+				? abs_normals[p][0] * rx[i] + abs_normals[p][1] * ry[i]
+				  + abs_normals[p][2] * rz[i]
+				: rx[i];
+			inside = (dist + reach >= 0.0f);
+		}
+		visible[i] = inside ? 1 : 0;
+		num_visible += visible[i];
+	}
+
+	frame_stats.visible += num_visible;
+	frame_stats.culled += count - num_visible;
+	return num_visible;
+}
+
+int
+cull_spheres(const float *x, const float *y, const float *z,
+             const float *radius, int count, unsigned char *visible)
+{
+	return _cull(x, y, z, radius, NULL, NULL, count, visible);
+}
+
+int
+cull_boxes(const float *x, const float *y, const float *z,
+           const float *ex, const float *ey, const float *ez,
+           int count, unsigned char *visible)
+{
+	return _cull(x, y, z, ex, ey, ez, count, visible);
+}
+
+void
+cull_get_stats(CullStats *stats)
+{
+	*stats = last_stats;
+}
@@ -0,0 +1,24 @@
+#ifndef CULL_HPP_INCLUDED
+#define CULL_HPP_INCLUDED
+
+// Frustum culling of bounding volumes given as separate
+// coordinate arrays, so that four of them are tested per
+// iteration when SSE is available.
+
+struct CullStats
+{
+	int visible;
+	int culled;
+};
+
+void cull_begin_frame(void);
+void cull_end_frame(void); // After the last test; publishes the stats
+void cull_set_frustum(const float *clip);
+int  cull_spheres(const float *x, const float *y, const float *z,
+                  const float *radius, int count, unsigned char *visible);
+int  cull_boxes(const float *x, const float *y, const float *z,
+                const float *ex, const float *ey, const float *ez,
+                int count, unsigned char *visible);
+void cull_get_stats(CullStats *stats); // Last finished frame
+
+#endif // CULL_HPP_INCLUDED
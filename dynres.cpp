@@ -0,0 +1,289 @@
+#include "dynres.hpp"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <cmath>
+#include <cstring>
+
+#include "fps.hpp"
+#include "layer.hpp"
+#include "render.hpp"
+#include "overdraw.hpp"
+#include "log.hpp"
+#include "gltrace.hpp"
+#include "glstats.hpp"
+
+// Controller gains, on the frame time error as a fraction of the budget
+#define DYNRES_KP     0.05 // Scale per unit of error
+#define DYNRES_KI     0.5  // Scale per unit of error per second
+#define DYNRES_KD     0.005 // Scale per unit of error change per second
+#define DYNRES_FILTER 0.1  // Weight of the newest frame time
+
+static bool   enabled   = false;
+static double budget    = 16.7;
+static float  limit_min = 0.5f;
+static float  limit_max = 1.0f;
+
+// Controller
+static double filtered_ms = -1.0;
+static double integral    = 0.0;
+static float  scale       = 1.0f;
+
+// Offscreen target
+static GLuint texture     = 0;
+static GLuint framebuffer = 0;
+static GLuint depth       = 0;
+static int    texture_w   = 0;
+static int    texture_h   = 0;
+
+// Current frame
+static bool   active   = false;
+static GLint  viewport[4];
+static GLuint previous = 0;
+static int    width    = 0;
+static int    height   = 0;
+
+static DynresStats stats;
+static double      sum_scale = 0.0;
+
+static void
+_reset(void)
+{
+	filtered_ms = -1.0;
+	integral = limit_max / DYNRES_KI; // Starts at the top with no error
+	scale = limit_max;
+	width = height = 0;
+
+	memset(&stats, 0, sizeof(DynresStats));
+	stats.min_scale = limit_max;
+	stats.max_scale = 0.0f;
+	sum_scale = 0.0;
+}
+
+void
+dynres_enable(bool enable)
+{
+	if(enable && !enabled)
+		_reset();
+	enabled = enable;
+}
+
+bool
+dynres_enabled(void)
+{
+	return enabled;
+}
+
+void
+dynres_set_budget(double ms)
+{
+	if(ms > 0.0)
+		budget = ms;
+}
+
+void
+dynres_set_limits(float min_scale, float max_scale)
+{
+	if(min_scale > 0.0f && min_scale <= max_scale && max_scale <= 1.0f) {
+		limit_min = min_scale;
+		limit_max = max_scale;
+		_reset();
+	}
+}
+
+// One step of the controller, on the frame that just ended
+static void
+_control(void)
+{
+	float last;
+	if(getFrameTimes(&last, 1) == 0 || last <= 0.0f)
+		return;
+
+	double previous_ms = filtered_ms;
+	if(filtered_ms < 0.0)
+		previous_ms = filtered_ms = last;
+	else filtered_ms += DYNRES_FILTER * (last - filtered_ms);
+
+	double dt = last / 1000.0;
+	double error = (budget - filtered_ms) / budget;
+	if(error < -1.0)
+		error = -1.0; // A long hitch is not a reason to drop to the floor at once
+	double derivative = (previous_ms - filtered_ms) / budget / dt;
+
+	// Stop integrating while the output is clamped, so it does not wind up
+	double next = integral + error * dt;
+	double output = DYNRES_KP * error + DYNRES_KI * next + DYNRES_KD * derivative;
+	if((output > limit_max && error > 0.0) || (output < limit_min && error < 0.0))
+		output = DYNRES_KP * error + DYNRES_KI * integral + DYNRES_KD * derivative;
+	else integral = next;
+
+	if(output < limit_min) output = limit_min;
+	if(output > limit_max) output = limit_max;
+	scale = (float)output;
+}
+
+// Switches only once the ideal size is a whole step away from the
+// current one, so noise around a step does not flip it every frame
+static int
+_snap(int size, int current)
+{
+	float ideal = size * scale;
+	if(ideal >= size)
+		return size;
+	if(current > 0 && current < size && fabsf(ideal - current) < DYNRES_SNAP)
+		return current;
+
+	int snapped = (int)(ideal / DYNRES_SNAP + 0.5f) * DYNRES_SNAP;
+	if(snapped < size * limit_min)
+		snapped += DYNRES_SNAP;
+	if(snapped < DYNRES_SNAP)
+		snapped = DYNRES_SNAP;
+	return snapped < size ? snapped : size;
+}
+
+static int
+_power_of_two(int size)
+{
+	int p = 1;
+	while(p < size)
+		p <<= 1;
+	return p;
+}
+
+static void
+_free_target(void)
+{
+	if(framebuffer)
+		layer_target_free(framebuffer, depth);
+	if(texture)
+		free_texture(texture);
+	framebuffer = depth = texture = 0;
+	texture_w = texture_h = 0;
+}
+
+// Sized for the full viewport, the scene uses the bottom left corner
+static void
+_allocate(int full_w, int full_h)
+{
+	int tw = _power_of_two(full_w), th = _power_of_two(full_h);
+	if(texture && tw == texture_w && th == texture_h)
+		return;
+
+	_free_target();
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tw, th, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	track_texture(texture, (unsigned long)tw * th * 4);
+	texture_w = tw;
+	texture_h = th;
+
+	framebuffer = layer_target_create(texture, tw, th, &depth);
+	if(!framebuffer)
+		log_info("dynres: no framebuffer objects, scaling through the back buffer");
+}
+
+void
+dynres_begin(void)
+{
+	active = false;
+	if(!enabled || gltrace_on || overdraw_enabled())
+		return;
+
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	_control();
+
+	int w = _snap(viewport[2], width), h = _snap(viewport[3], height);
+	if(w != width || h != height) {
+		if(width)
+			stats.changes++;
+		width = w;
+		height = h;
+	}
+
+	float effective = (float)w / viewport[2];
+	stats.frames++;
+	sum_scale += effective;
+	if(effective < stats.min_scale) stats.min_scale = effective;
+	if(effective > stats.max_scale) stats.max_scale = effective;
+
+	if(w == viewport[2] && h == viewport[3])
+		return;
+
+	_allocate(viewport[2], viewport[3]);
+	if(framebuffer) {
+		previous = layer_target_bind(framebuffer);
+		glViewport(0, 0, w, h);
+	} else {
+		glViewport(viewport[0], viewport[1], w, h);
+	}
+	active = true;
+}
+
+void
+dynres_end(void)
+{
+	if(!active)
+		return;
+	active = false;
+
+	if(framebuffer) {
+		layer_target_bind(previous);
+	} else {
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, viewport[0], viewport[1],
+		                    width, height);
+	}
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glClear(GL_DEPTH_BUFFER_BIT); // Overlays get a fresh one either way
+
+	float u = (float)width / texture_w;
+	float v = (float)height / texture_h;
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glLoadIdentity();
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	glBegin(GL_QUADS);
+		glTexCoord2f(0.0f, 0.0f);
+		glVertex2f(-1.0f, -1.0f);
+		glTexCoord2f(u, 0.0f);
+		glVertex2f(1.0f, -1.0f);
+		glTexCoord2f(u, v);
+		glVertex2f(1.0f, 1.0f);
+		glTexCoord2f(0.0f, v);
+		glVertex2f(-1.0f, 1.0f);
+	glEnd();
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+	glEnable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+}
+
+void
+dynres_stats(DynresStats *out)
+{
+	*out = stats;
+	out->scale = scale;
+	out->width = width;
+	out->height = height;
+	out->frame_ms = filtered_ms > 0.0 ? filtered_ms : 0.0;
+	out->budget_ms = budget;
+	out->average_scale = stats.frames ? sum_scale / stats.frames : 0.0;
+	if(stats.frames == 0)
+		out->min_scale = out->max_scale = 0.0f;
+}
+
+void
+dynres_dispose(void)
+{
+	_free_target();
+	enabled = false;
+}
@@ -0,0 +1,42 @@
+#ifndef DYNRES_HPP_INCLUDED
+#define DYNRES_HPP_INCLUDED
+
+// Dynamic resolution. While enabled the scene is drawn at a fraction of
+// the viewport into an offscreen target, then stretched over the whole
+// viewport with bilinear filtering; whatever is drawn after dynres_end
+// stays at full resolution. At full scale the scene is drawn directly.
+//
+// The scale follows a PID controller fed with the filtered wall-clock
+// frame time against a budget. Sizes snap to DYNRES_SNAP pixels so the
+// target does not change on every frame. Frames waiting on vsync count
+// as work, so the budget should sit above the refresh interval.
+//
+// Renders through a framebuffer object with a depth buffer when there
+// is one (see layer.hpp), otherwise into a corner of the back buffer
+// that is copied out. Off while capturing or showing overdraw.
+
+#define DYNRES_SNAP 8
+
+struct DynresStats
+{
+	float        scale;          // Per axis
+	int          width, height;  // Scene resolution
+	double       frame_ms;       // Filtered, as seen by the controller
+	double       budget_ms;
+	float        min_scale;      // Lowest and highest reached
+	float        max_scale;
+	double       average_scale;
+	unsigned int changes;        // Resolution switches
+	unsigned int frames;
+};
+
+void dynres_enable(bool enabled);
+bool dynres_enabled(void);
+void dynres_set_budget(double ms);
+void dynres_set_limits(float min_scale, float max_scale);
+void dynres_begin(void); // Before the clear
+void dynres_end(void);   // After the scene, before overlays
+void dynres_stats(DynresStats *stats);
+void dynres_dispose(void);
+
+#endif // DYNRES_HPP_INCLUDED
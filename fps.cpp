@@ -1,27 +1,62 @@
-#include <GL/glut.h>
 #include "fps.hpp"
+#include <cstdlib>
+
+#include "timer.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 static double fps        = 1.0f;
 static double deltaTime  = 1.0f;
+static double fixedStep  = 0.0f;
 static int frame         = 0;
-static int time          = 0;
-static int lasttime      = 0;
-static int timebase      = 0;
+static double currtime   = 0;
+static double lasttime   = 0;
+static double timebase   = 0;
+
+static float history[FPS_HISTORY]; // Ring of frame times, in ms
+static int   history_count = 0;
+
+static int   window_timer = TIMER_NONE;
+
+// Closes the one second window the FPS is averaged over
+static void
+_fps_window(void *data)
+{
+	fps = frame * 1000.0 / (currtime - timebase);
+	timebase = currtime;
+	frame = 0;
+}
 
 void
 fpsUpdate(void)
 {
 	frame++;
-	lasttime = time;
-	time = glutGet(GLUT_ELAPSED_TIME);
+	lasttime = currtime;
+	currtime = getElapsedTime() * 1000.0;
 
-	deltaTime = (double)(time - lasttime);
+	if(window_timer == TIMER_NONE) {
+		timebase = currtime;
+		window_timer = timer_add(1000.0, 1000.0, _fps_window, NULL);
+	}
 
-	if(time - timebase > 1000.0) {
-		fps = frame * 1000.0 / (time - timebase);
-		timebase = time;
-		frame = 0;
+	if(lasttime > 0.0) {
+		history[history_count % FPS_HISTORY] = (float)(currtime - lasttime);
+		history_count++;
 	}
+
+	deltaTime = (fixedStep > 0.0)
+		? fixedStep * 1000.0
+		: currtime - lasttime;
+}
+
+void
+fpsSetFixedStep(double seconds)
+{
+	fixedStep = seconds;
 }
 
 double
@@ -34,4 +69,71 @@ double
 getDeltaTime(void)
 {
 	return deltaTime / 1000.0;
+}
+
+double
+getFrameClock(void)
+{
+	return currtime;
+}
+
+int
+getFrameTimes(float *times, int max)
+{
+	int count = history_count < FPS_HISTORY ? history_count : FPS_HISTORY;
+	if(count > max)
+		count = max;
+	for(int i = 0; i < count; i++)
+		times[i] = history[(history_count - count + i) % FPS_HISTORY];
+	return count;
+}
+
+static int
+_compare_floats(const void *a, const void *b)
+{
+	float x = *(const float*)a, y = *(const float*)b;
+	return (x > y) - (x < y);
+}
+
+double
+getFrameTimePercentile(double percentile)
+{
+	return getRecentFrameTimePercentile(percentile, FPS_HISTORY);
+}
+
+double
+getRecentFrameTimePercentile(double percentile, int frames)
+{
+	float sorted[FPS_HISTORY];
+	int count = getFrameTimes(sorted, frames < FPS_HISTORY ? frames : FPS_HISTORY);
+	if(count == 0)
+		return 0.0;
+
+	qsort(sorted, count, sizeof(float), _compare_floats);
+	int rank = (int)(percentile / 100.0 * count);
+	if(rank >= count)
+		rank = count - 1;
+	return sorted[rank];
+}
+
+double
+getElapsedTime(void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER freq, start;
+	LARGE_INTEGER now;
+	if(freq.QuadPart == 0) {
+		QueryPerformanceFrequency(&freq);
+		QueryPerformanceCounter(&start);
+	}
+	QueryPerformanceCounter(&now);
+	return (double)(now.QuadPart - start.QuadPart) / (double)freq.QuadPart;
+#else
+	static struct timespec start;
+	struct timespec now;
+	if(start.tv_sec == 0 && start.tv_nsec == 0)
+		clock_gettime(CLOCK_MONOTONIC, &start);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9;
+#endif
 }
\ No newline at end of file
@@ -2,7 +2,16 @@
 #define FPS_HPP_DEFINED
 
 void   fpsUpdate(void);
+void   fpsSetFixedStep(double seconds); // 0 goes back to real time
 double getFps(void);
 double getDeltaTime(void); // Returns deltaTime in seconds
+double getElapsedTime(void); // Monotonic clock, in seconds
+double getFrameClock(void); // getElapsedTime at the last fpsUpdate, in ms
+
+// Wall-clock frame times of the last FPS_HISTORY frames, in ms
+#define FPS_HISTORY 240
+int    getFrameTimes(float *times, int max); // Oldest first
+double getFrameTimePercentile(double percentile);
+double getRecentFrameTimePercentile(double percentile, int frames); // Newest only
 
 #endif // FPS_HPP_DEFINED
\ No newline at end of file
@@ -0,0 +1,461 @@
+// Offline GL trace replay. Re-issues a stream captured with
+// `MyGame --capture` on an offscreen context as fast as possible, so
+// driver and rasterizer cost can be measured apart from the game.
+//
+//   glreplay trace.bin [--loops N] [--out file.json]
+//
+// The whole trace runs once to upload textures and warm up; the
+// frames after the first are then replayed N times and timed.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <GL/gl.h>
+
+#include "fps.hpp"
+#include "gltrace.hpp"
+#include "headless.hpp"
+
+#define GLREPLAY_MAX_TEXTURES 256
+
+struct TextureName
+{
+	GLuint recorded;
+	GLuint actual;
+};
+
+static unsigned int *trace     = NULL; // Whole file, as words
+static unsigned int  num_words = 0;
+
+static TextureName textures[GLREPLAY_MAX_TEXTURES];
+static int         num_textures = 0;
+
+static unsigned int unpack_alignment = 4; // As last set by the trace
+
+// A capture cut short, by a killed game or a full disk, ends mid-command
+static void
+_truncated(unsigned int pos)
+{
+	fprintf(stderr, "glreplay: truncated trace at word %u\n", pos);
+	exit(1);
+}
+
+// A blob holding less than the call would read from it
+static void
+_short_blob(unsigned int pos)
+{
+	fprintf(stderr, "glreplay: short data at word %u\n", pos);
+	exit(1);
+}
+
+static unsigned int
+_u32(unsigned int pos)
+{
+	if(pos >= num_words)
+		_truncated(pos);
+	const unsigned char *b = (const unsigned char*)(trace + pos);
+	return b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int)b[3] << 24);
+}
+
+static float
+_f32(unsigned int pos)
+{
+	unsigned int bits = _u32(pos);
+	float value;
+	memcpy(&value, &bits, 4);
+	return value;
+}
+
+// needed is what the call will read, in bytes
+static const void *
+_blob(unsigned int *pos, unsigned int *size, double needed)
+{
+	*size = _u32(*pos);
+	unsigned int words = *size / 4 + (*size % 4 != 0);
+	if(words > num_words - (*pos + 1))
+		_truncated(*pos);
+	if(*size < needed)
+		_short_blob(*pos);
+	const void *data = *size ? (const void*)(trace + *pos + 1) : NULL;
+	*pos += 1 + words;
+	return data;
+}
+
+// Bytes read by glTex(Sub)Image2D, rows padded to the unpack alignment
+static double
+_image_bytes(unsigned int width, unsigned int height, GLenum format, GLenum type)
+{
+	double row = (double)width * gltrace_pixel_bytes(format, type);
+	return ceil(row / unpack_alignment) * unpack_alignment * height;
+}
+
+static GLuint
+_texture(GLuint recorded)
+{
+	for(int i = 0; i < num_textures; i++) {
+		if(textures[i].recorded == recorded)
+			return textures[i].actual;
+	}
+	return recorded;
+}
+
+static bool
+_load(const char *path, int *width, int *height)
+{
+	FILE *in = fopen(path, "rb");
+	if(!in) {
+		fprintf(stderr, "glreplay: cannot open %s\n", path);
+		return false;
+	}
+
+	fseek(in, 0, SEEK_END);
+	long size = ftell(in);
+	fseek(in, 0, SEEK_SET);
+
+	num_words = (unsigned int)(size / 4);
+	trace = (unsigned int*)malloc(num_words * 4 + 4);
+	bool ok = fread(trace, 4, num_words, in) == num_words;
+	fclose(in);
+
+	if(!ok || num_words < 4 || memcmp(trace, GLTRACE_MAGIC, 4)
+	   || _u32(1) == 0 || _u32(1) > GLTRACE_VERSION) {
+		fprintf(stderr, "glreplay: %s is not a GL trace\n", path);
+		return false;
+	}
+
+	*width = (int)_u32(2);
+	*height = (int)_u32(3);
+	return true;
+}
+
+// Highest index plus one: the array entries glDrawElements reads
+static double
+_index_count(const void *indices, GLsizei count, GLenum type)
+{
+	unsigned int last = 0;
+	for(GLsizei i = 0; i < count; i++) {
+		unsigned int index;
+		switch(type) {
+		case GL_UNSIGNED_BYTE:  index = ((const unsigned char*)indices)[i];  break;
+		case GL_UNSIGNED_SHORT: index = ((const unsigned short*)indices)[i]; break;
+		default:                index = ((const unsigned int*)indices)[i];   break;
+		}
+		if(index > last)
+			last = index;
+	}
+	return count ? last + 1.0 : 0.0;
+}
+
+// Client arrays following a draw command, each holding at least
+// elements entries; returns the new position
+static unsigned int
+_arrays(unsigned int pos, double elements)
+{
+	static const GLenum names[GLTRACE_ARRAYS] = {
+		GL_VERTEX_ARRAY, GL_NORMAL_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY
+	};
+	unsigned int mask = _u32(pos++);
+
+	for(int i = 0; i < GLTRACE_ARRAYS; i++) {
+		if(!(mask & (1u << i)))
+			continue;
+
+		GLint size = (GLint)_u32(pos);
+		GLenum type = _u32(pos + 1);
+		unsigned int bytes;
+		if(size < 1 || size > 4)
+			_short_blob(pos);
+		pos += 2;
+		const void *data = _blob(&pos, &bytes,
+			elements * size * gltrace_type_size(type));
+
+		switch(names[i]) {
+		case GL_VERTEX_ARRAY:   glVertexPointer(size, type, 0, data);   break;
+		case GL_NORMAL_ARRAY:   glNormalPointer(type, 0, data);         break;
+		case GL_COLOR_ARRAY:    glColorPointer(size, type, 0, data);    break;
+		default:                glTexCoordPointer(size, type, 0, data); break;
+		}
+	}
+	return pos;
+}
+
+// Executes commands in [pos, end); returns the frames seen
+static int
+_execute(unsigned int pos, unsigned int end, unsigned int *stop)
+{
+	while(pos < end) {
+		unsigned int op = _u32(pos++);
+		unsigned int size;
+		const void *data;
+		GLfloat params[16];
+
+		switch(op) {
+		case GLTRACE_FRAME:
+			*stop = pos;
+			return 1;
+		case GLTRACE_BEGIN:
+			glBegin(_u32(pos));
+			pos += 1;
+			break;
+		case GLTRACE_END:
+			glEnd();
+			break;
+		case GLTRACE_VERTEX2F:
+			glVertex2f(_f32(pos), _f32(pos + 1));
+			pos += 2;
+			break;
+		case GLTRACE_VERTEX3F:
+			glVertex3f(_f32(pos), _f32(pos + 1), _f32(pos + 2));
+			pos += 3;
+			break;
+		case GLTRACE_TEXCOORD2F:
+			glTexCoord2f(_f32(pos), _f32(pos + 1));
+			pos += 2;
+			break;
+		case GLTRACE_COLOR4F:
+			glColor4f(_f32(pos), _f32(pos + 1), _f32(pos + 2), _f32(pos + 3));
+			pos += 4;
+			break;
+		case GLTRACE_ENABLE:
+			glEnable(_u32(pos));
+			pos += 1;
+			break;
+		case GLTRACE_DISABLE:
+			glDisable(_u32(pos));
+			pos += 1;
+			break;
+		case GLTRACE_BLENDFUNC:
+			glBlendFunc(_u32(pos), _u32(pos + 1));
+			pos += 2;
+			break;
+		case GLTRACE_SHADEMODEL:
+			glShadeModel(_u32(pos));
+			pos += 1;
+			break;
+		case GLTRACE_DEPTHMASK:
+			glDepthMask((GLboolean)_u32(pos));
+			pos += 1;
+			break;
+		case GLTRACE_PIXELSTOREI: {
+			GLenum pname = _u32(pos);
+			unsigned int param = _u32(pos + 1);
+			if(pname == GL_UNPACK_ALIGNMENT && (param == 1 || param == 2
+			   || param == 4 || param == 8))
+				unpack_alignment = param;
+			glPixelStorei(pname, (GLint)param);
+			pos += 2;
+			break;
+		}
+		case GLTRACE_MATERIALFV:
+		case GLTRACE_LIGHTFV: {
+			GLenum target = _u32(pos), pname = _u32(pos + 1);
+			int count = gltrace_param_count(pname);
+			for(int i = 0; i < count; i++)
+				params[i] = _f32(pos + 2 + i);
+			if(op == GLTRACE_MATERIALFV)
+				glMaterialfv(target, pname, params);
+			else glLightfv(target, pname, params);
+			pos += 2 + count;
+			break;
+		}
+		case GLTRACE_BINDTEXTURE:
+			glBindTexture(_u32(pos), _texture(_u32(pos + 1)));
+			pos += 2;
+			break;
+		case GLTRACE_TEXPARAMETERI:
+			glTexParameteri(_u32(pos), _u32(pos + 1), (GLint)_u32(pos + 2));
+			pos += 3;
+			break;
+		case GLTRACE_TEXIMAGE2D: {
+			unsigned int at = pos + 8;
+			// No data allocates the texture without uploading
+			data = _blob(&at, &size, _u32(at) ? _image_bytes(_u32(pos + 3),
+				_u32(pos + 4), _u32(pos + 6), _u32(pos + 7)) : 0.0);
+			glTexImage2D(_u32(pos), (GLint)_u32(pos + 1), (GLint)_u32(pos + 2),
+			             (GLsizei)_u32(pos + 3), (GLsizei)_u32(pos + 4),
+			             (GLint)_u32(pos + 5), _u32(pos + 6), _u32(pos + 7), data);
+			pos = at;
+			break;
+		}
+		case GLTRACE_TEXSUBIMAGE2D: {
+			unsigned int at = pos + 8;
+			data = _blob(&at, &size, _image_bytes(_u32(pos + 4),
+				_u32(pos + 5), _u32(pos + 6), _u32(pos + 7)));
+			glTexSubImage2D(_u32(pos), (GLint)_u32(pos + 1),
+			                (GLint)_u32(pos + 2), (GLint)_u32(pos + 3),
+			                (GLsizei)_u32(pos + 4), (GLsizei)_u32(pos + 5),
+			                _u32(pos + 6), _u32(pos + 7), data);
+			pos = at;
+			break;
+		}
+		case GLTRACE_GENTEXTURES: {
+			unsigned int n = _u32(pos++);
+			for(unsigned int i = 0; i < n; i++, pos++) {
+				GLuint name;
+				glGenTextures(1, &name);
+				if(num_textures < GLREPLAY_MAX_TEXTURES) {
+					textures[num_textures].recorded = _u32(pos);
+					textures[num_textures].actual = name;
+					num_textures++;
+				}
+			}
+			break;
+		}
+		case GLTRACE_DELETETEXTURES: {
+			unsigned int n = _u32(pos++);
+			for(unsigned int i = 0; i < n; i++, pos++) {
+				GLuint name = _texture(_u32(pos));
+				glDeleteTextures(1, &name);
+			}
+			break;
+		}
+		case GLTRACE_LOADMATRIXF:
+			for(int i = 0; i < 16; i++)
+				params[i] = _f32(pos + i);
+			glLoadMatrixf(params);
+			pos += 16;
+			break;
+		case GLTRACE_LOADIDENTITY:
+			glLoadIdentity();
+			break;
+		case GLTRACE_ENABLECLIENTSTATE:
+			glEnableClientState(_u32(pos));
+			pos += 1;
+			break;
+		case GLTRACE_DISABLECLIENTSTATE:
+			glDisableClientState(_u32(pos));
+			pos += 1;
+			break;
+		case GLTRACE_DRAWARRAYS: {
+			GLenum mode = _u32(pos);
+			GLsizei count = (GLsizei)_u32(pos + 1);
+			pos = _arrays(pos + 2, count > 0 ? count : 0);
+			glDrawArrays(mode, 0, count);
+			break;
+		}
+		case GLTRACE_DRAWELEMENTS: {
+			GLenum mode = _u32(pos);
+			GLsizei count = (GLsizei)_u32(pos + 1);
+			GLenum type = _u32(pos + 2);
+			pos += 3;
+			if(count < 0)
+				_short_blob(pos);
+			data = _blob(&pos, &size, (double)count * gltrace_type_size(type));
+			pos = _arrays(pos, _index_count(data, count, type));
+			glDrawElements(mode, count, type, data);
+			break;
+		}
+		case GLTRACE_CLEAR:
+			glClear(_u32(pos));
+			pos += 1;
+			break;
+		default:
+			fprintf(stderr, "glreplay: bad opcode %u at word %u\n", op, pos - 1);
+			exit(1);
+		}
+	}
+
+	*stop = end;
+	return 0;
+}
+
+static int
+_compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *path = NULL, *output = NULL;
+	int loops = 10, width, height;
+
+	for(int i = 1; i < argc; i++) {
+		bool has_value = (i + 1 < argc);
+		if(!strcmp(argv[i], "--loops") && has_value)
+			loops = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--out") && has_value)
+			output = argv[++i];
+		else path = argv[i];
+	}
+
+	if(!path || loops < 1) {
+		fprintf(stderr, "usage: glreplay trace.bin [--loops N] [--out file.json]\n");
+		return 1;
+	}
+
+	if(!_load(path, &width, &height) || !headless_create(width, height))
+		return 1;
+
+	// First pass: setup, uploads and every frame once
+	unsigned int pos = 4, first_frame = 0, last_frame = 0;
+	int frames = 0;
+	while(pos < num_words) {
+		if(!_execute(pos, num_words, &pos))
+			break;
+		if(frames++ == 0)
+			first_frame = pos;
+		last_frame = pos;
+	}
+	glFinish();
+
+	int count = (frames - 1) * loops;
+	if(count <= 0) {
+		fprintf(stderr, "glreplay: need at least two captured frames\n");
+		return 1;
+	}
+
+	double *times = (double*)malloc(count * sizeof(double));
+	double total = 0.0;
+	int n = 0;
+	for(int l = 0; l < loops; l++) {
+		pos = first_frame;
+		while(pos < last_frame) {
+			double start = getElapsedTime();
+			_execute(pos, last_frame, &pos);
+			glFinish();
+			times[n] = (getElapsedTime() - start) * 1000.0;
+			total += times[n++];
+		}
+	}
+
+	qsort(times, count, sizeof(double), _compare_doubles);
+
+	FILE *out = output ? fopen(output, "w") : stdout;
+	if(!out) {
+		fprintf(stderr, "glreplay: cannot open %s\n", output);
+		return 1;
+	}
+
+	const char *renderer = (const char*)glGetString(GL_RENDERER);
+
+	fprintf(out, "{\n");
+	fprintf(out, "  \"renderer\": \"%s\",\n", renderer ? renderer : "unknown");
+	fprintf(out, "  \"trace\": \"%s\",\n", path);
+	fprintf(out, "  \"width\": %d,\n", width);
+	fprintf(out, "  \"height\": %d,\n", height);
+	fprintf(out, "  \"trace_bytes\": %u,\n", num_words * 4);
+	fprintf(out, "  \"frames\": %d,\n", count);
+	fprintf(out, "  \"loops\": %d,\n", loops);
+	fprintf(out, "  \"total_ms\": %.3f,\n", total);
+	fprintf(out, "  \"fps\": %.2f,\n", 1000.0 * count / total);
+	fprintf(out, "  \"frame_ms\": {\n");
+	fprintf(out, "    \"min\": %.4f,\n", times[0]);
+	fprintf(out, "    \"mean\": %.4f,\n", total / count);
+	fprintf(out, "    \"p50\": %.4f,\n", times[count / 2]);
+	fprintf(out, "    \"p99\": %.4f,\n", times[(count * 99) / 100]);
+	fprintf(out, "    \"max\": %.4f\n", times[count - 1]);
+	fprintf(out, "  }\n");
+	fprintf(out, "}\n");
+
+	if(out != stdout)
+		fclose(out);
+
+	free(times);
+	free(trace);
+	headless_destroy();
+	return 0;
+}
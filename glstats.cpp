@@ -0,0 +1,69 @@
+#include "glstats.hpp"
+#include <cstring>
+
+static GLStats last_frame;
+
+#ifdef GLSTATS
+GLStats      glstats_current;
+GLenum       glstats_mode          = GL_POINTS;
+unsigned int glstats_pending       = 0;
+unsigned int glstats_array_bytes   = 0;
+unsigned int glstats_array_size[4] = { 0, 0, 0, 0 };
+bool         glstats_array_on[4]   = { false, false, false, false };
+
+unsigned int
+glstats_array_index(GLenum array)
+{
+	switch(array) {
+	case GL_NORMAL_ARRAY:        return 1;
+	case GL_COLOR_ARRAY:         return 2;
+	case GL_TEXTURE_COORD_ARRAY: return 3;
+	default:                     return 0;
+	}
+}
+
+void
+glstats_update_arrays(void)
+{
+	glstats_array_bytes = 0;
+	for(int i = 0; i < 4; i++) {
+		if(glstats_array_on[i])
+			glstats_array_bytes += glstats_array_size[i];
+	}
+}
+#endif
+
+bool
+glstats_enabled(void)
+{
+#ifdef GLSTATS
+	return true;
+#else
+	return false;
+#endif
+}
+
+void
+glstats_frame(void)
+{
+#ifdef GLSTATS
+	last_frame = glstats_current;
+	memset(&glstats_current, 0, sizeof(GLStats));
+#endif
+}
+
+void
+glstats_last(GLStats *stats)
+{
+	*stats = last_frame;
+}
+
+const char *
+glstats_primitive_name(int mode)
+{
+	static const char *names[GLSTATS_PRIMITIVES] = {
+		"points", "lines", "line_loop", "line_strip", "triangles",
+		"triangle_strip", "triangle_fan", "quads", "quad_strip", "polygon"
+	};
+	return (mode >= 0 && mode < GLSTATS_PRIMITIVES) ? names[mode] : "unknown";
+}
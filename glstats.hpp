@@ -0,0 +1,467 @@
+#ifndef GLSTATS_HPP_INCLUDED
+#define GLSTATS_HPP_INCLUDED
+
+#include <GL/gl.h>
+
+// Per-frame GL call counters. Build with -DGLSTATS (make GLSTATS=1)
+// and include this header after every other GL header: the GL entry
+// points used by the renderer are then replaced by inline wrappers
+// that count calls before forwarding them. Without GLSTATS nothing
+// is wrapped and all counters stay at zero.
+
+#define GLSTATS_PRIMITIVES 10 // GL_POINTS up to GL_POLYGON
+
+struct GLStats
+{
+	unsigned int  calls;          // Every wrapped GL call
+	unsigned int  draw_calls;     // glBegin/glEnd pairs and glDraw*
+	unsigned int  vertices[GLSTATS_PRIMITIVES];
+	unsigned int  state_changes;  // Enables, blend, lights, materials...
+	unsigned int  texture_binds;
+	unsigned int  matrix_loads;
+	unsigned long bytes_uploaded; // Texture data and client arrays
+};
+
+bool        glstats_enabled(void);
+void        glstats_frame(void); // Closes the current frame
+void        glstats_last(GLStats *stats);
+const char *glstats_primitive_name(int mode);
+
+#ifdef GLSTATS
+
+#include "gltrace.hpp"
+
+extern GLStats glstats_current;
+
+// Immediate mode and client array bookkeeping
+extern GLenum       glstats_mode;
+extern unsigned int glstats_pending;
+extern unsigned int glstats_array_bytes; // Bytes per vertex, enabled arrays
+extern unsigned int glstats_array_size[4];
+extern bool         glstats_array_on[4];
+
+unsigned int glstats_array_index(GLenum array);
+void         glstats_update_arrays(void);
+
+static inline unsigned int
+glstats_type_size(GLenum type)
+{
+	switch(type) {
+	case GL_BYTE: case GL_UNSIGNED_BYTE:   return 1;
+	case GL_SHORT: case GL_UNSIGNED_SHORT: return 2;
+	case GL_DOUBLE:                        return 8;
+	default:                               return 4;
+	}
+}
+
+static inline void
+glstats_glBegin(GLenum mode)
+{
+	glstats_current.calls++;
+	glstats_mode = mode;
+	glstats_pending = 0;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_BEGIN); gltrace_u32(mode);
+	}
+	glBegin(mode);
+}
+
+static inline void
+glstats_glEnd(void)
+{
+	glstats_current.calls++;
+	glstats_current.draw_calls++;
+	if(glstats_mode < GLSTATS_PRIMITIVES)
+		glstats_current.vertices[glstats_mode] += glstats_pending;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_END);
+	}
+	glEnd();
+}
+
+static inline void
+glstats_glVertex2f(GLfloat x, GLfloat y)
+{
+	glstats_current.calls++;
+	glstats_pending++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_VERTEX2F); gltrace_f32(x); gltrace_f32(y);
+	}
+	glVertex2f(x, y);
+}
+
+static inline void
+glstats_glVertex3f(GLfloat x, GLfloat y, GLfloat z)
+{
+	glstats_current.calls++;
+	glstats_pending++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_VERTEX3F); gltrace_f32(x); gltrace_f32(y); gltrace_f32(z);
+	}
+	glVertex3f(x, y, z);
+}
+
+static inline void
+glstats_glTexCoord2f(GLfloat s, GLfloat t)
+{
+	glstats_current.calls++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_TEXCOORD2F); gltrace_f32(s); gltrace_f32(t);
+	}
+	glTexCoord2f(s, t);
+}
+
+static inline void
+glstats_glColor4f(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+	glstats_current.calls++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_COLOR4F); gltrace_f32(r); gltrace_f32(g); gltrace_f32(b); gltrace_f32(a);
+	}
+	glColor4f(r, g, b, a);
+}
+
+static inline void
+glstats_glEnable(GLenum cap)
+{
+	glstats_current.calls++;
+	glstats_current.state_changes++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_ENABLE); gltrace_u32(cap);
+	}
+	glEnable(cap);
+}
+
+static inline void
+glstats_glDisable(GLenum cap)
+{
+	glstats_current.calls++;
+	glstats_current.state_changes++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_DISABLE); gltrace_u32(cap);
+	}
+	glDisable(cap);
+}
+
+static inline void
+glstats_glBlendFunc(GLenum src, GLenum dst)
+{
+	glstats_current.calls++;
+	glstats_current.state_changes++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_BLENDFUNC); gltrace_u32(src); gltrace_u32(dst);
+	}
+	glBlendFunc(src, dst);
+}
+
+static inline void
+glstats_glShadeModel(GLenum mode)
+{
+	glstats_current.calls++;
+	glstats_current.state_changes++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_SHADEMODEL); gltrace_u32(mode);
+	}
+	glShadeModel(mode);
+}
+
+static inline void
+glstats_glDepthMask(GLboolean flag)
+{
+	glstats_current.calls++;
+	glstats_current.state_changes++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_DEPTHMASK); gltrace_u32(flag);
+	}
+	glDepthMask(flag);
+}
+
+static inline void
+glstats_glPixelStorei(GLenum pname, GLint param)
+{
+	glstats_current.calls++;
+	glstats_current.state_changes++;
+	gltrace_pixel_store(pname, param);
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_PIXELSTOREI); gltrace_u32(pname); gltrace_u32(param);
+	}
+	glPixelStorei(pname, param);
+}
+
+static inline void
+glstats_glMaterialfv(GLenum face, GLenum pname, const GLfloat *params)
+{
+	glstats_current.calls++;
+	glstats_current.state_changes++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_MATERIALFV); gltrace_u32(face); gltrace_u32(pname);
+		gltrace_floats(params, gltrace_param_count(pname));
+	}
+	glMaterialfv(face, pname, params);
+}
+
+static inline void
+glstats_glLightfv(GLenum light, GLenum pname, const GLfloat *params)
+{
+	glstats_current.calls++;
+	glstats_current.state_changes++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_LIGHTFV); gltrace_u32(light); gltrace_u32(pname);
+		gltrace_floats(params, gltrace_param_count(pname));
+	}
+	glLightfv(light, pname, params);
+}
+
+static inline void
+glstats_glBindTexture(GLenum target, GLuint texture)
+{
+	glstats_current.calls++;
+	glstats_current.texture_binds++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_BINDTEXTURE); gltrace_u32(target); gltrace_u32(texture);
+	}
+	glBindTexture(target, texture);
+}
+
+static inline void
+glstats_glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+	glstats_current.calls++;
+	glstats_current.state_changes++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_TEXPARAMETERI); gltrace_u32(target); gltrace_u32(pname); gltrace_u32(param);
+	}
+	glTexParameteri(target, pname, param);
+}
+
+static inline void
+glstats_glTexImage2D(GLenum target, GLint level, GLint internal,
+                     GLsizei width, GLsizei height, GLint border,
+                     GLenum format, GLenum type, const GLvoid *pixels)
+{
+	glstats_current.calls++;
+	if(pixels)
+		glstats_current.bytes_uploaded +=
+			width * height * gltrace_pixel_bytes(format, type);
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_TEXIMAGE2D);
+		gltrace_u32(target); gltrace_u32(level); gltrace_u32(internal);
+		gltrace_u32(width); gltrace_u32(height); gltrace_u32(border);
+		gltrace_u32(format); gltrace_u32(type);
+		gltrace_image(width, height, gltrace_pixel_bytes(format, type), pixels);
+	}
+	glTexImage2D(target, level, internal, width, height, border,
+	             format, type, pixels);
+}
+
+static inline void
+glstats_glTexSubImage2D(GLenum target, GLint level, GLint x, GLint y,
+                        GLsizei width, GLsizei height,
+                        GLenum format, GLenum type, const GLvoid *pixels)
+{
+	glstats_current.calls++;
+	glstats_current.bytes_uploaded +=
+		width * height * gltrace_pixel_bytes(format, type);
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_TEXSUBIMAGE2D);
+		gltrace_u32(target); gltrace_u32(level); gltrace_u32(x); gltrace_u32(y);
+		gltrace_u32(width); gltrace_u32(height);
+		gltrace_u32(format); gltrace_u32(type);
+		gltrace_image(width, height, gltrace_pixel_bytes(format, type), pixels);
+	}
+	glTexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+}
+
+static inline void
+glstats_glGenTextures(GLsizei n, GLuint *textures)
+{
+	glstats_current.calls++;
+	glGenTextures(n, textures);
+	if(gltrace_on) {
+		// Names are recorded so the replay can map them to its own
+		gltrace_op(GLTRACE_GENTEXTURES);
+		gltrace_u32(n);
+		for(GLsizei i = 0; i < n; i++)
+			gltrace_u32(textures[i]);
+	}
+}
+
+static inline void
+glstats_glDeleteTextures(GLsizei n, const GLuint *textures)
+{
+	glstats_current.calls++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_DELETETEXTURES);
+		gltrace_u32(n);
+		for(GLsizei i = 0; i < n; i++)
+			gltrace_u32(textures[i]);
+	}
+	glDeleteTextures(n, textures);
+}
+
+static inline void
+glstats_glLoadMatrixf(const GLfloat *m)
+{
+	glstats_current.calls++;
+	glstats_current.matrix_loads++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_LOADMATRIXF); gltrace_floats(m, 16);
+	}
+	glLoadMatrixf(m);
+}
+
+static inline void
+glstats_glLoadIdentity(void)
+{
+	glstats_current.calls++;
+	glstats_current.matrix_loads++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_LOADIDENTITY);
+	}
+	glLoadIdentity();
+}
+
+static inline void
+glstats_glEnableClientState(GLenum array)
+{
+	glstats_current.calls++;
+	glstats_current.state_changes++;
+	glstats_array_on[glstats_array_index(array)] = true;
+	glstats_update_arrays();
+	gltrace_client_state(array, true);
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_ENABLECLIENTSTATE); gltrace_u32(array);
+	}
+	glEnableClientState(array);
+}
+
+static inline void
+glstats_glDisableClientState(GLenum array)
+{
+	glstats_current.calls++;
+	glstats_current.state_changes++;
+	glstats_array_on[glstats_array_index(array)] = false;
+	glstats_update_arrays();
+	gltrace_client_state(array, false);
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_DISABLECLIENTSTATE); gltrace_u32(array);
+	}
+	glDisableClientState(array);
+}
+
+static inline void
+glstats_glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *ptr)
+{
+	glstats_current.calls++;
+	glstats_array_size[0] = size * glstats_type_size(type);
+	glstats_update_arrays();
+	gltrace_pointer(GL_VERTEX_ARRAY, size, type, stride, ptr);
+	glVertexPointer(size, type, stride, ptr);
+}
+
+static inline void
+glstats_glNormalPointer(GLenum type, GLsizei stride, const GLvoid *ptr)
+{
+	glstats_current.calls++;
+	glstats_array_size[1] = 3 * glstats_type_size(type);
+	glstats_update_arrays();
+	gltrace_pointer(GL_NORMAL_ARRAY, 3, type, stride, ptr);
+	glNormalPointer(type, stride, ptr);
+}
+
+static inline void
+glstats_glColorPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *ptr)
+{
+	glstats_current.calls++;
+	glstats_array_size[2] = size * glstats_type_size(type);
+	glstats_update_arrays();
+	gltrace_pointer(GL_COLOR_ARRAY, size, type, stride, ptr);
+	glColorPointer(size, type, stride, ptr);
+}
+
+static inline void
+glstats_glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *ptr)
+{
+	glstats_current.calls++;
+	glstats_array_size[3] = size * glstats_type_size(type);
+	glstats_update_arrays();
+	gltrace_pointer(GL_TEXTURE_COORD_ARRAY, size, type, stride, ptr);
+	glTexCoordPointer(size, type, stride, ptr);
+}
+
+static inline void
+glstats_glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	glstats_current.calls++;
+	glstats_current.draw_calls++;
+	if(mode < GLSTATS_PRIMITIVES)
+		glstats_current.vertices[mode] += count;
+	glstats_current.bytes_uploaded += count * glstats_array_bytes;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_DRAWARRAYS);
+		gltrace_u32(mode); gltrace_u32(count);
+		gltrace_arrays(first, count);
+	}
+	glDrawArrays(mode, first, count);
+}
+
+static inline void
+glstats_glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices)
+{
+	glstats_current.calls++;
+	glstats_current.draw_calls++;
+	if(mode < GLSTATS_PRIMITIVES)
+		glstats_current.vertices[mode] += count;
+	// Upper bound: every index may reference a different vertex
+	glstats_current.bytes_uploaded +=
+		count * (glstats_type_size(type) + glstats_array_bytes);
+	if(gltrace_on)
+		gltrace_elements(mode, count, type, indices);
+	glDrawElements(mode, count, type, indices);
+}
+
+static inline void
+glstats_glClear(GLbitfield mask)
+{
+	glstats_current.calls++;
+	if(gltrace_on) {
+		gltrace_op(GLTRACE_CLEAR); gltrace_u32(mask);
+	}
+	glClear(mask);
+}
+
+#define glBegin              glstats_glBegin
+#define glEnd                glstats_glEnd
+#define glVertex2f           glstats_glVertex2f
+#define glVertex3f           glstats_glVertex3f
+#define glTexCoord2f         glstats_glTexCoord2f
+#define glColor4f            glstats_glColor4f
+#define glEnable             glstats_glEnable
+#define glDisable            glstats_glDisable
+#define glBlendFunc          glstats_glBlendFunc
+#define glShadeModel         glstats_glShadeModel
+#define glDepthMask          glstats_glDepthMask
+#define glPixelStorei        glstats_glPixelStorei
+#define glMaterialfv         glstats_glMaterialfv
+#define glLightfv            glstats_glLightfv
+#define glBindTexture        glstats_glBindTexture
+#define glTexParameteri      glstats_glTexParameteri
+#define glTexImage2D         glstats_glTexImage2D
+#define glTexSubImage2D      glstats_glTexSubImage2D
+#define glGenTextures        glstats_glGenTextures
+#define glDeleteTextures     glstats_glDeleteTextures
+#define glLoadMatrixf        glstats_glLoadMatrixf
+#define glLoadIdentity       glstats_glLoadIdentity
+#define glEnableClientState  glstats_glEnableClientState
+#define glDisableClientState glstats_glDisableClientState
+#define glVertexPointer      glstats_glVertexPointer
+#define glNormalPointer      glstats_glNormalPointer
+#define glColorPointer       glstats_glColorPointer
+#define glTexCoordPointer    glstats_glTexCoordPointer
+#define glDrawArrays         glstats_glDrawArrays
+#define glDrawElements       glstats_glDrawElements
+#define glClear              glstats_glClear
+
+#endif // GLSTATS
+
+#endif // GLSTATS_HPP_INCLUDED
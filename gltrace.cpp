@@ -0,0 +1,286 @@
+#include "gltrace.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "memory.hpp"
+
+bool gltrace_on = false;
+
+struct TraceArray
+{
+	bool          enabled;
+	GLint         size;
+	GLenum        type;
+	GLsizei       stride;
+	const GLvoid *pointer;
+};
+
+static FILE       *stream        = NULL;
+static int         frames_left   = 0;
+static int         frames_traced = 0;
+static TraceArray  arrays[GLTRACE_ARRAYS];
+static int         unpack_alignment = 4;
+
+static unsigned char *scratch      = NULL; // Packed client array data
+static unsigned int   scratch_size = 0;
+
+static void
+_at_exit(void)
+{
+	gltrace_end();
+}
+
+unsigned int
+gltrace_type_size(GLenum type)
+{
+	switch(type) {
+	case GL_BYTE: case GL_UNSIGNED_BYTE:   return 1;
+	case GL_SHORT: case GL_UNSIGNED_SHORT: return 2;
+	case GL_DOUBLE:                        return 8;
+	default:                               return 4;
+	}
+}
+
+unsigned int
+gltrace_pixel_bytes(GLenum format, GLenum type)
+{
+	unsigned int components;
+	switch(format) {
+	case GL_ALPHA: case GL_LUMINANCE: case GL_RED:
+	case GL_STENCIL_INDEX: case GL_DEPTH_COMPONENT:
+		components = 1;
+		break;
+	case GL_LUMINANCE_ALPHA:
+		components = 2;
+		break;
+	case GL_RGB:
+		components = 3;
+		break;
+	default:
+		components = 4;
+		break;
+	}
+	return components * gltrace_type_size(type);
+}
+
+static int
+_array_index(GLenum array)
+{
+	switch(array) {
+	case GL_NORMAL_ARRAY:        return 1;
+	case GL_COLOR_ARRAY:         return 2;
+	case GL_TEXTURE_COORD_ARRAY: return 3;
+	default:                     return 0;
+	}
+}
+
+bool
+gltrace_begin(const char *path, int frames, int width, int height)
+{
+	gltrace_end();
+#ifndef GLSTATS
+	fprintf(stderr, "gltrace: capture needs a GLSTATS=1 build\n");
+	return false;
+#endif
+	stream = fopen(path, "wb");
+	if(!stream) {
+		fprintf(stderr, "gltrace: cannot create %s\n", path);
+		return false;
+	}
+
+	fwrite(GLTRACE_MAGIC, 1, 4, stream);
+	gltrace_u32(GLTRACE_VERSION);
+	gltrace_u32(width);
+	gltrace_u32(height);
+
+	memset(arrays, 0, sizeof(arrays));
+	frames_left = frames;
+	frames_traced = 0;
+	gltrace_on = true;
+
+	static bool registered = false;
+	if(!registered) {
+		atexit(_at_exit);
+		registered = true;
+	}
+	return true;
+}
+
+void
+gltrace_frame(void)
+{
+	if(!gltrace_on)
+		return;
+	gltrace_op(GLTRACE_FRAME);
+	frames_traced++;
+	if(--frames_left <= 0)
+		gltrace_end();
+}
+
+void
+gltrace_end(void)
+{
+	if(stream) {
+		fclose(stream);
+		fprintf(stderr, "gltrace: captured %d frames\n", frames_traced);
+	}
+	stream = NULL;
+	gltrace_on = false;
+	mem_free(scratch);
+	scratch = NULL;
+	scratch_size = 0;
+}
+
+void
+gltrace_op(unsigned int op)
+{
+	gltrace_u32(op);
+}
+
+void
+gltrace_u32(unsigned int value)
+{
+	unsigned char bytes[4];
+	bytes[0] = (unsigned char)value;
+	bytes[1] = (unsigned char)(value >> 8);
+	bytes[2] = (unsigned char)(value >> 16);
+	bytes[3] = (unsigned char)(value >> 24);
+	fwrite(bytes, 1, 4, stream);
+}
+
+void
+gltrace_f32(float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, 4);
+	gltrace_u32(bits);
+}
+
+void
+gltrace_floats(const float *values, int count)
+{
+	for(int i = 0; i < count; i++)
+		gltrace_f32(values[i]);
+}
+
+void
+gltrace_blob(const void *data, unsigned int size)
+{
+	static const unsigned char pad[4] = { 0, 0, 0, 0 };
+	gltrace_u32(size);
+	if(size)
+		fwrite(data, 1, size, stream);
+	fwrite(pad, 1, (4 - (size & 3)) & 3, stream);
+}
+
+void
+gltrace_client_state(GLenum array, bool enabled)
+{
+	arrays[_array_index(array)].enabled = enabled;
+}
+
+void
+gltrace_pixel_store(GLenum pname, GLint param)
+{
+	if(pname == GL_UNPACK_ALIGNMENT)
+		unpack_alignment = param;
+}
+
+void
+gltrace_pointer(GLenum array, GLint size, GLenum type,
+                GLsizei stride, const GLvoid *pointer)
+{
+	TraceArray &a = arrays[_array_index(array)];
+	a.size = size;
+	a.type = type;
+	a.stride = stride;
+	a.pointer = pointer;
+}
+
+// Writes the enabled client arrays for elements [first, first + count)
+// tightly packed, as a mask followed by size, type and data per array.
+void
+gltrace_arrays(int first, int count)
+{
+	unsigned int mask = 0;
+	for(int i = 0; i < GLTRACE_ARRAYS; i++) {
+		if(arrays[i].enabled && arrays[i].pointer)
+			mask |= 1u << i;
+	}
+	gltrace_u32(mask);
+
+	for(int i = 0; i < GLTRACE_ARRAYS; i++) {
+		if(!(mask & (1u << i)))
+			continue;
+
+		const TraceArray &a = arrays[i];
+		unsigned int element = a.size * gltrace_type_size(a.type);
+		unsigned int stride = a.stride ? a.stride : element;
+		unsigned int size = element * count;
+		if(size > scratch_size) {
+			scratch = (unsigned char*)mem_realloc(scratch, size);
+			scratch_size = size;
+		}
+
+		const unsigned char *src = (const unsigned char*)a.pointer + first * stride;
+		for(int e = 0; e < count; e++)
+			memcpy(scratch + e * element, src + e * stride, element);
+
+		gltrace_u32(a.size);
+		gltrace_u32(a.type);
+		gltrace_blob(scratch, size);
+	}
+}
+
+void
+gltrace_elements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices)
+{
+	unsigned int last = 0;
+	for(GLsizei i = 0; i < count; i++) {
+		unsigned int index;
+		switch(type) {
+		case GL_UNSIGNED_BYTE:  index = ((const GLubyte*)indices)[i];  break;
+		case GL_UNSIGNED_SHORT: index = ((const GLushort*)indices)[i]; break;
+		default:                index = ((const GLuint*)indices)[i];   break;
+		}
+		if(index > last)
+			last = index;
+	}
+
+	gltrace_op(GLTRACE_DRAWELEMENTS);
+	gltrace_u32(mode);
+	gltrace_u32(count);
+	gltrace_u32(type);
+	gltrace_blob(indices, count * gltrace_type_size(type));
+	gltrace_arrays(0, count ? last + 1 : 0);
+}
+
+// Rows are padded to the current GL_UNPACK_ALIGNMENT
+void
+gltrace_image(int width, int height, unsigned int pixel_bytes,
+              const GLvoid *pixels)
+{
+	unsigned int row = (width * pixel_bytes + unpack_alignment - 1)
+	                 / unpack_alignment * unpack_alignment;
+	gltrace_blob(pixels, pixels ? row * height : 0);
+}
+
+// Number of floats read by glMaterialfv/glLightfv for a parameter
+int
+gltrace_param_count(GLenum pname)
+{
+	switch(pname) {
+	case GL_SHININESS:
+	case GL_SPOT_EXPONENT:
+	case GL_SPOT_CUTOFF:
+	case GL_CONSTANT_ATTENUATION:
+	case GL_LINEAR_ATTENUATION:
+	case GL_QUADRATIC_ATTENUATION:
+		return 1;
+	case GL_SPOT_DIRECTION:
+		return 3;
+	default:
+		return 4;
+	}
+}
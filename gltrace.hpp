@@ -0,0 +1,80 @@
+#ifndef GLTRACE_HPP_INCLUDED
+#define GLTRACE_HPP_INCLUDED
+
+#include <GL/gl.h>
+
+// GL command stream capture. The wrappers in glstats.hpp write every
+// call, with the data it reads from client memory, into a binary
+// trace while capture is on. bin/glreplay re-issues a trace as fast
+// as possible on an offscreen context.
+//
+// Layout: "MGGL", u32 version, u32 width, u32 height, then commands.
+// Each command is a u32 opcode followed by its arguments as u32/f32
+// words; blobs are a u32 byte size followed by the bytes, padded to
+// four. GLTRACE_FRAME marks a buffer swap.
+
+#define GLTRACE_MAGIC   "MGGL"
+#define GLTRACE_VERSION 2 // 1 lacks DEPTHMASK and PIXELSTOREI
+
+enum GLTraceOp
+{
+	GLTRACE_FRAME = 1,
+	GLTRACE_BEGIN,
+	GLTRACE_END,
+	GLTRACE_VERTEX2F,
+	GLTRACE_VERTEX3F,
+	GLTRACE_TEXCOORD2F,
+	GLTRACE_COLOR4F,
+	GLTRACE_ENABLE,
+	GLTRACE_DISABLE,
+	GLTRACE_BLENDFUNC,
+	GLTRACE_SHADEMODEL,
+	GLTRACE_MATERIALFV,
+	GLTRACE_LIGHTFV,
+	GLTRACE_BINDTEXTURE,
+	GLTRACE_TEXPARAMETERI,
+	GLTRACE_TEXIMAGE2D,
+	GLTRACE_TEXSUBIMAGE2D,
+	GLTRACE_GENTEXTURES,
+	GLTRACE_DELETETEXTURES,
+	GLTRACE_LOADMATRIXF,
+	GLTRACE_LOADIDENTITY,
+	GLTRACE_ENABLECLIENTSTATE,
+	GLTRACE_DISABLECLIENTSTATE,
+	GLTRACE_DRAWARRAYS,   // Followed by the enabled client arrays
+	GLTRACE_DRAWELEMENTS, // Indices blob, then the enabled client arrays
+	GLTRACE_CLEAR,
+	GLTRACE_DEPTHMASK,
+	GLTRACE_PIXELSTOREI,
+	GLTRACE_OP_COUNT
+};
+
+// Client arrays, in the order they are written after draw commands
+#define GLTRACE_ARRAYS 4 // Vertex, normal, color, texture coordinate
+
+extern bool gltrace_on;
+
+bool gltrace_begin(const char *path, int frames, int width, int height);
+void gltrace_frame(void);
+void gltrace_end(void);
+
+void gltrace_op(unsigned int op);
+void gltrace_u32(unsigned int value);
+void gltrace_f32(float value);
+void gltrace_floats(const float *values, int count);
+void gltrace_blob(const void *data, unsigned int size);
+
+void gltrace_client_state(GLenum array, bool enabled);
+void gltrace_pixel_store(GLenum pname, GLint param);
+void gltrace_pointer(GLenum array, GLint size, GLenum type,
+                     GLsizei stride, const GLvoid *pointer);
+void gltrace_arrays(int first, int count);
+void gltrace_elements(GLenum mode, GLsizei count, GLenum type,
+                      const GLvoid *indices);
+void gltrace_image(int width, int height, unsigned int pixel_bytes,
+                   const GLvoid *pixels);
+int  gltrace_param_count(GLenum pname);
+unsigned int gltrace_type_size(GLenum type);
+unsigned int gltrace_pixel_bytes(GLenum format, GLenum type);
+
+#endif // GLTRACE_HPP_INCLUDED
@@ -0,0 +1,112 @@
+#include "headless.hpp"
+#include <cstdio>
+
+#ifndef _WIN32
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLSurface surface = EGL_NO_SURFACE;
+static EGLContext context = EGL_NO_CONTEXT;
+
+bool
+headless_create(int width, int height)
+{
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)
+		eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if(get_platform_display)
+		display = get_platform_display(
+			EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	if(display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	if(display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+		fprintf(stderr, "headless: cannot initialize EGL display\n");
+		return false;
+	}
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE,        8,
+		EGL_GREEN_SIZE,      8,
+		EGL_BLUE_SIZE,       8,
+		EGL_DEPTH_SIZE,      24,
+		EGL_STENCIL_SIZE,    8,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint num_configs = 0;
+	if(!eglChooseConfig(display, config_attribs, &config, 1, &num_configs)
+	   || num_configs == 0) {
+		fprintf(stderr, "headless: no suitable EGL config\n");
+		return false;
+	}
+
+	const EGLint pbuffer_attribs[] = {
+		EGL_WIDTH,  width,
+		EGL_HEIGHT, height,
+		EGL_NONE
+	};
+
+	surface = eglCreatePbufferSurface(display, config, pbuffer_attribs);
+	eglBindAPI(EGL_OPENGL_API);
+	context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+
+	if(surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT
+	   || !eglMakeCurrent(display, surface, surface, context)) {
+		fprintf(stderr, "headless: cannot create offscreen GL context\n");
+		return false;
+	}
+
+	return true;
+}
+
+void
+headless_destroy(void)
+{
+	if(display != EGL_NO_DISPLAY) {
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if(context != EGL_NO_CONTEXT)
+			eglDestroyContext(display, context);
+		if(surface != EGL_NO_SURFACE)
+			eglDestroySurface(display, surface);
+		eglTerminate(display);
+	}
+	display = EGL_NO_DISPLAY;
+	surface = EGL_NO_SURFACE;
+	context = EGL_NO_CONTEXT;
+}
+
+void *
+headless_proc_address(const char *name)
+{
+	if(context == EGL_NO_CONTEXT)
+		return NULL;
+	return (void*)eglGetProcAddress(name);
+}
+
+#else
+
+bool
+headless_create(int width, int height)
+{
+	fprintf(stderr, "headless: offscreen contexts are not supported on Windows\n");
+	return false;
+}
+
+void
+headless_destroy(void)
+{
+}
+
+void *
+headless_proc_address(const char *name)
+{
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HEADLESS_HPP_INCLUDED
+#define HEADLESS_HPP_INCLUDED
+
+// Offscreen GL context on an EGL pbuffer, using Mesa's surfaceless
+// platform when available, so no X server is needed.
+
+bool headless_create(int width, int height);
+void headless_destroy(void);
+
+// GL entry points of the offscreen context, NULL when there is none
+void *headless_proc_address(const char *name);
+
+#endif // HEADLESS_HPP_INCLUDED
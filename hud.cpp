@@ -0,0 +1,145 @@
+#include "hud.hpp"
+
+#include "fps.hpp"
+#include "text.hpp"
+#include "cull.hpp"
+#include "mesh.hpp"
+#include "memory.hpp"
+#include "profile.hpp"
+#include "glstats.hpp"
+#include "dynres.hpp"
+
+#define HUD_LINES       4
+#define HUD_TEXT_PERIOD 0.25 // Seconds between text refreshes
+#define HUD_MARGIN      4
+#define HUD_GRAPH_BARS  120
+#define HUD_GRAPH_H     40
+#define HUD_GRAPH_MS    33.3f // Frame time at the top of the graph
+#define HUD_PANEL_W     (TEXT_GLYPH_W * 36 + HUD_MARGIN * 2)
+
+#define HUD_PANEL   0x000000a0
+#define HUD_TEXT    0xffffffff
+#define HUD_GOOD    0x40e040ff
+#define HUD_SLOW    0xe0e040ff
+#define HUD_BAD     0xe04040ff
+#define HUD_BUDGET  0xffffff60
+
+static bool    enabled = false;
+static TextRun lines[HUD_LINES];
+static double  last_text = -1.0;
+
+void
+hud_init(void)
+{
+	text_init();
+	for(int i = 0; i < HUD_LINES; i++)
+		text_run_init(&lines[i]);
+	last_text = -1.0;
+}
+
+void
+hud_enable(bool enable)
+{
+	enabled = enable;
+}
+
+bool
+hud_enabled(void)
+{
+	return enabled;
+}
+
+static void
+_update_text(void)
+{
+	const char *text[HUD_LINES];
+
+	if(dynres_enabled()) {
+		DynresStats dynres;
+		dynres_stats(&dynres);
+		text[0] = mem_frame_printf("FPS %.1f  max %.2f ms  res %d%%",
+		                           getFps(), getFrameTimePercentile(100.0),
+		                           (int)(dynres.scale * 100.0f + 0.5f));
+	} else {
+		text[0] = mem_frame_printf("FPS %.1f  max %.2f ms",
+		                           getFps(), getFrameTimePercentile(100.0));
+	}
+	text[1] = mem_frame_printf("p50 %.2f  p90 %.2f  p99 %.2f ms",
+	                           getFrameTimePercentile(50.0),
+	                           getFrameTimePercentile(90.0),
+	                           getFrameTimePercentile(99.0));
+
+	CullStats cull;
+	cull_get_stats(&cull);
+	if(glstats_enabled()) {
+		GLStats gl;
+		glstats_last(&gl);
+		text[2] = mem_frame_printf("draws %u  calls %u  tris %d",
+		                           gl.draw_calls, gl.calls,
+		                           mesh_triangles_submitted());
+	} else {
+		text[2] = mem_frame_printf("visible %d  culled %d  tris %d",
+		                           cull.visible, cull.culled,
+		                           mesh_triangles_submitted());
+	}
+
+	MemStats mem;
+	mem_last(&mem);
+	text[3] = mem_frame_printf("heap %lu KB  allocs %u/frame",
+	                           mem.bytes_live / 1024, mem.allocs);
+
+	float y = HUD_MARGIN + HUD_GRAPH_H + HUD_MARGIN;
+	for(int i = 0; i < HUD_LINES; i++) {
+		text_run_set(&lines[i], HUD_MARGIN * 2, y, HUD_TEXT, text[i]);
+		y += TEXT_GLYPH_H + 2;
+	}
+}
+
+void
+hud_draw(void)
+{
+	static int zone = profile_zone("hud");
+
+	if(!enabled)
+		return;
+
+	ProfileScope scope(zone);
+
+	double now = getElapsedTime();
+	if(now - last_text >= HUD_TEXT_PERIOD || last_text < 0.0) {
+		_update_text();
+		last_text = now;
+	}
+
+	float width = HUD_PANEL_W;
+	float height = HUD_GRAPH_H + HUD_LINES * (TEXT_GLYPH_H + 2) + HUD_MARGIN * 3;
+
+	text_begin();
+	text_add_rect(HUD_MARGIN, HUD_MARGIN, width, height, HUD_PANEL);
+
+	// Frame time graph, newest on the right, two pixels per frame
+	float times[HUD_GRAPH_BARS];
+	int count = getFrameTimes(times, HUD_GRAPH_BARS);
+	float base = HUD_MARGIN * 2 + HUD_GRAPH_H;
+	for(int i = 0; i < count; i++) {
+		float h = times[i] / HUD_GRAPH_MS * HUD_GRAPH_H;
+		if(h > HUD_GRAPH_H)
+			h = HUD_GRAPH_H;
+		unsigned int color = times[i] <= 16.7f ? HUD_GOOD
+			: (times[i] <= HUD_GRAPH_MS ? HUD_SLOW : HUD_BAD);
+		float x = HUD_MARGIN * 2 + (HUD_GRAPH_BARS - count + i) * 2;
+		text_add_rect(x, base - h, 2, h, color);
+	}
+	text_add_rect(HUD_MARGIN * 2, base - HUD_GRAPH_H / 2, HUD_GRAPH_BARS * 2, 1,
+	              HUD_BUDGET); // 16.7ms
+
+	for(int i = 0; i < HUD_LINES; i++)
+		text_add_run(&lines[i]);
+	text_flush();
+}
+
+void
+hud_dispose(void)
+{
+	text_dispose();
+}
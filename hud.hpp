@@ -0,0 +1,16 @@
+#ifndef HUD_HPP_INCLUDED
+#define HUD_HPP_INCLUDED
+
+// Performance overlay: frame time graph, frame time percentiles,
+// GL and scene counters, and memory. The text refreshes four times a
+// second, the graph every frame. Panel, graph and text are batched
+// into one draw call, drawn directly: a cached layer would blend a
+// viewport sized quad to show a small corner of it.
+
+void hud_init(void); // Needs a GL context
+void hud_enable(bool enabled);
+bool hud_enabled(void);
+void hud_draw(void); // After the scene, before the swap
+void hud_dispose(void);
+
+#endif // HUD_HPP_INCLUDED
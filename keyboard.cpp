@@ -1,31 +1,176 @@
 #include "keyboard.hpp"
 #include <cstring>
 
+#include "fps.hpp"
+
 static KeyboardState current_state;
-static KeyboardState prev_state;
+static KeyboardState next_state; // Accumulates events until the next latch
+
+static signed char keymap[256];
+
+// Events queued since the last latch. GLUT callbacks and the
+// simulation run on the same thread, so no locking is needed.
+static KeyboardEvent queue[KBD_MAX_EVENTS];
+static int queue_head  = 0;
+static int queue_count = 0;
+
+// Events applied since the last latch, and the ones consumed
+// by the last latch, oldest first
+static KeyboardEvent applied[KBD_MAX_EVENTS];
+static KeyboardEvent latched[KBD_MAX_EVENTS];
+static int num_applied = 0;
+static int num_latched = 0;
+
+static void
+_apply(const KeyboardEvent &ev)
+{
+	unsigned int bit = 1u << ev.button;
+	if(ev.state) {
+		if(!(next_state.held & bit))
+			next_state.pressed |= bit;
+		next_state.held |= bit;
+	} else {
+		if(next_state.held & bit)
+			next_state.released |= bit;
+		next_state.held &= ~bit;
+	}
+
+	if(num_applied < KBD_MAX_EVENTS)
+		applied[num_applied++] = ev;
+}
 
 void
 kbdInit(void)
 {
-	memset(current_state.btns, 0, 7 * sizeof(bool));
-	memset(prev_state.btns, 0, 7 * sizeof(bool));
+	memset(&current_state, 0, sizeof(KeyboardState));
+	memset(&next_state, 0, sizeof(KeyboardState));
+	queue_head = queue_count = 0;
+	num_applied = num_latched = 0;
+
+	memset(keymap, BTN_NONE, sizeof(keymap));
+	kbdMapKey('w', BTN_UP);
+	kbdMapKey('a', BTN_LEFT);
+	kbdMapKey('s', BTN_DOWN);
+	kbdMapKey('d', BTN_RIGHT);
+	kbdMapKey('k', BTN_ACTION1);
+	kbdMapKey('i', BTN_ACTION2);
+	kbdMapKey(10, BTN_START);
+}
+
+void
+kbdMapKey(unsigned char key, int button)
+{
+	keymap[key] = (signed char)button;
+
+	// Letters work regardless of caps lock
+	if(key >= 'a' && key <= 'z')
+		keymap[key - 'a' + 'A'] = (signed char)button;
+	else if(key >= 'A' && key <= 'Z')
+		keymap[key - 'A' + 'a'] = (signed char)button;
+}
+
+bool
+kbdKeyEvent(unsigned char key, bool state)
+{
+	int button = keymap[key];
+	if(button == BTN_NONE)
+		return false;
+
+	kbdUpdateButton((unsigned int)button, state);
+	return true;
 }
 
 void
 kbdUpdateButton(unsigned int button, bool state)
 {
-	prev_state.btns[button] = current_state.btns[button];
-	current_state.btns[button] = state;
+	if(button >= BTN_COUNT)
+		return;
+
+	// When full, fold the oldest event in early. Its edges are
+	// kept, so nothing is lost, only its place in the queue.
+	if(queue_count == KBD_MAX_EVENTS) {
+		_apply(queue[queue_head]);
+		queue_head = (queue_head + 1) % KBD_MAX_EVENTS;
+		queue_count--;
+	}
+
+	KeyboardEvent &ev = queue[(queue_head + queue_count) % KBD_MAX_EVENTS];
+	ev.time = getElapsedTime();
+	ev.button = button;
+	ev.state = state;
+	queue_count++;
+}
+
+void
+kbdLatch(void)
+{
+	while(queue_count > 0) {
+		_apply(queue[queue_head]);
+		queue_head = (queue_head + 1) % KBD_MAX_EVENTS;
+		queue_count--;
+	}
+
+	current_state = next_state;
+	next_state.pressed = next_state.released = 0;
+
+	memcpy(latched, applied, num_applied * sizeof(KeyboardEvent));
+	num_latched = num_applied;
+	num_applied = 0;
 }
 
 bool
 kbdPressing(unsigned int button)
 {
-	return current_state.btns[button];
+	// A tap shorter than a tick still counts for that tick
+	return ((current_state.held | current_state.pressed) >> button) & 1;
 }
 
 bool
 kbdPressed(unsigned int button)
 {
-	return current_state.btns[button] && !prev_state.btns[button];
+	return (current_state.pressed >> button) & 1;
+}
+
+bool
+kbdReleased(unsigned int button)
+{
+	return (current_state.released >> button) & 1;
+}
+
+unsigned int
+kbdGetButtons(void)
+{
+	return current_state.held;
+}
+
+unsigned int
+kbdPeekButtons(void)
+{
+	unsigned int held = next_state.held;
+	for(int i = 0; i < queue_count; i++) {
+		const KeyboardEvent &ev = queue[(queue_head + i) % KBD_MAX_EVENTS];
+		if(ev.state)
+			held |= 1u << ev.button;
+		else held &= ~(1u << ev.button);
+	}
+	return held;
+}
+
+unsigned int
+kbdGetPressed(void)
+{
+	return current_state.pressed;
+}
+
+unsigned int
+kbdGetReleased(void)
+{
+	return current_state.released;
+}
+
+int
+kbdLatchedEvents(const KeyboardEvent **events)
+{
+	*events = latched;
+	return num_latched;
 }
@@ -8,15 +8,38 @@
 #define BTN_START   0x4
 #define BTN_ACTION1 0x5
 #define BTN_ACTION2 0x6
+#define BTN_COUNT   7
+#define BTN_NONE    -1
 
+#define KBD_MAX_EVENTS 64
+
+// Button states as (1 << BTN_*) masks, latched once per tick
 struct KeyboardState
 {
-	bool btns[7];
+	unsigned int held;     // Down at the end of the tick
+	unsigned int pressed;  // Went down during the tick
+	unsigned int released; // Went up during the tick
+};
+
+struct KeyboardEvent
+{
+	double       time; // getElapsedTime() when the event arrived
+	unsigned int button;
+	bool         state;
 };
 
 void kbdInit(void);
+void kbdMapKey(unsigned char key, int button); // BTN_NONE unmaps
+bool kbdKeyEvent(unsigned char key, bool state); // false if key is unmapped
 void kbdUpdateButton(unsigned int button, bool state);
+void kbdLatch(void);
 bool kbdPressing(unsigned int button);
 bool kbdPressed(unsigned int button);
+bool kbdReleased(unsigned int button);
+unsigned int kbdGetButtons(void); // (1 << BTN_*) mask of held buttons
+unsigned int kbdPeekButtons(void); // Held buttons including unlatched events
+unsigned int kbdGetPressed(void);
+unsigned int kbdGetReleased(void);
+int  kbdLatchedEvents(const KeyboardEvent **events);
 
 #endif // KEYBOARD_HPP_INCLUDED
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "latency.hpp"
+#include <cstdlib>
+#include <cstring>
+
+#include "fps.hpp"
+#include "keyboard.hpp"
+
+#define LATENCY_TYPES   (BTN_COUNT * 2) // Press and release per button
+#define LATENCY_SAMPLES 1024            // Kept per type for percentiles
+#define LATENCY_PENDING 128
+
+static const char *button_names[BTN_COUNT] = {
+	"up", "down", "left", "right", "start", "action1", "action2"
+};
+
+struct PendingSample
+{
+	double       event_time;
+	double       latch_time;
+	unsigned int tick;
+	int          type;
+};
+
+struct LatencySeries
+{
+	double samples[LATENCY_SAMPLES]; // Ring of total latencies, in ms
+	double total_sum;
+	double queued_sum; // Time spent waiting for the latch
+	double max;
+	int    count;
+};
+
+static bool          enabled = false;
+static PendingSample pending[LATENCY_PENDING];
+static int           num_pending = 0;
+static LatencySeries series[LATENCY_TYPES];
+
+void
+latency_enable(bool enable)
+{
+	enabled = enable;
+	num_pending = 0;
+	memset(series, 0, sizeof(series));
+}
+
+bool
+latency_enabled(void)
+{
+	return enabled;
+}
+
+void
+latency_consume(unsigned int tick)
+{
+	if(!enabled)
+		return;
+
+	const KeyboardEvent *events;
+	int count = kbdLatchedEvents(&events);
+	double now = getElapsedTime();
+
+	for(int i = 0; i < count && num_pending < LATENCY_PENDING; i++) {
+		PendingSample &s = pending[num_pending++];
+		s.event_time = events[i].time;
+		s.latch_time = now;
+		s.tick = tick;
+		s.type = events[i].button * 2 + (events[i].state ? 0 : 1);
+	}
+}
+
+void
+latency_present(unsigned int tick)
+{
+	if(!enabled)
+		return;
+
+	double now = getElapsedTime();
+	int kept = 0;
+
+	for(int i = 0; i < num_pending; i++) {
+		const PendingSample &s = pending[i];
+		if(s.tick > tick) {
+			pending[kept++] = s;
+			continue;
+		}
+
+		LatencySeries &ser = series[s.type];
+		double total = (now - s.event_time) * 1000.0;
+		ser.samples[ser.count % LATENCY_SAMPLES] = total;
+		ser.total_sum += total;
+		ser.queued_sum += (s.latch_time - s.event_time) * 1000.0;
+		if(total > ser.max)
+			ser.max = total;
+		ser.count++;
+	}
+
+	num_pending = kept;
+}
+
+static int
+_compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+void
+latency_write_json(FILE *out, const char *indent)
+{
+	static double sorted[LATENCY_SAMPLES];
+	bool first = true;
+
+	fprintf(out, "{");
+	for(int t = 0; t < LATENCY_TYPES; t++) {
+		const LatencySeries &ser = series[t];
+		if(ser.count == 0)
+			continue;
+
+		int n = ser.count < LATENCY_SAMPLES ? ser.count : LATENCY_SAMPLES;
+		memcpy(sorted, ser.samples, n * sizeof(double));
+		qsort(sorted, n, sizeof(double), _compare_doubles);
+
+		fprintf(out, "%s\n%s  \"%s_%s\": { ", first ? "" : ",", indent,
+		        button_names[t / 2], (t & 1) ? "release" : "press");
+		fprintf(out, "\"count\": %d, ", ser.count);
+		fprintf(out, "\"mean_ms\": %.3f, ", ser.total_sum / ser.count);
+		fprintf(out, "\"queued_ms\": %.3f, ", ser.queued_sum / ser.count);
+		fprintf(out, "\"p50_ms\": %.3f, ", sorted[n / 2]);
+		fprintf(out, "\"p95_ms\": %.3f, ", sorted[(n * 95) / 100]);
+		fprintf(out, "\"max_ms\": %.3f }", ser.max);
+		first = false;
+	}
+	if(first)
+		fprintf(out, "}");
+	else fprintf(out, "\n%s}", indent);
+}
@@ -0,0 +1,17 @@
+#ifndef LATENCY_HPP_INCLUDED
+#define LATENCY_HPP_INCLUDED
+
+#include <cstdio>
+
+// Input-to-photon latency measurement. Input events carry the time
+// their callback ran; the tick that latches them is tagged, and the
+// latency is closed once the frame drawn after that tick has been
+// swapped and finished. Reported per button and direction.
+
+void latency_enable(bool enabled);
+bool latency_enabled(void);
+void latency_consume(unsigned int tick); // After kbdLatch
+void latency_present(unsigned int tick); // After swap + glFinish
+void latency_write_json(FILE *out, const char *indent);
+
+#endif // LATENCY_HPP_INCLUDED
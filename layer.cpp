@@ -0,0 +1,340 @@
+#include "layer.hpp"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <cstdio>
+
+#include "render.hpp"
+#include "log.hpp"
+#include "gltrace.hpp"
+#include "glstats.hpp"
+
+// Same values for the GL 3.0 names and the EXT_framebuffer_object ones
+#define LAYER_FRAMEBUFFER          0x8D40
+#define LAYER_FRAMEBUFFER_BINDING  0x8CA6
+#define LAYER_COLOR_ATTACHMENT0    0x8CE0
+#define LAYER_FRAMEBUFFER_COMPLETE 0x8CD5
+#define LAYER_RENDERBUFFER         0x8D41
+#define LAYER_DEPTH_ATTACHMENT     0x8D00
+#define LAYER_DEPTH_COMPONENT24    0x81A6
+
+typedef void   (APIENTRY *GenFramebuffersProc)(GLsizei count, GLuint *framebuffers);
+typedef void   (APIENTRY *DeleteFramebuffersProc)(GLsizei count, const GLuint *framebuffers);
+typedef void   (APIENTRY *BindFramebufferProc)(GLenum target, GLuint framebuffer);
+typedef void   (APIENTRY *FramebufferTexture2DProc)(GLenum target, GLenum attachment,
+                                                    GLenum textarget, GLuint texture,
+                                                    GLint level);
+typedef GLenum (APIENTRY *CheckFramebufferStatusProc)(GLenum target);
+typedef void   (APIENTRY *GenRenderbuffersProc)(GLsizei count, GLuint *renderbuffers);
+typedef void   (APIENTRY *DeleteRenderbuffersProc)(GLsizei count, const GLuint *renderbuffers);
+typedef void   (APIENTRY *BindRenderbufferProc)(GLenum target, GLuint renderbuffer);
+typedef void   (APIENTRY *RenderbufferStorageProc)(GLenum target, GLenum format,
+                                                   GLsizei width, GLsizei height);
+typedef void   (APIENTRY *FramebufferRenderbufferProc)(GLenum target, GLenum attachment,
+                                                       GLenum renderbuffer_target,
+                                                       GLuint renderbuffer);
+typedef void   (APIENTRY *BlendFuncSeparateProc)(GLenum src_rgb, GLenum dst_rgb,
+                                                 GLenum src_alpha, GLenum dst_alpha);
+
+static GenFramebuffersProc        gen_framebuffers;
+static DeleteFramebuffersProc     delete_framebuffers;
+static BindFramebufferProc        bind_framebuffer;
+static FramebufferTexture2DProc   framebuffer_texture_2d;
+static CheckFramebufferStatusProc check_framebuffer_status;
+static GenRenderbuffersProc       gen_renderbuffers;
+static DeleteRenderbuffersProc    delete_renderbuffers;
+static BindRenderbufferProc       bind_renderbuffer;
+static RenderbufferStorageProc    renderbuffer_storage;
+static FramebufferRenderbufferProc framebuffer_renderbuffer;
+static BlendFuncSeparateProc      blend_func_separate;
+
+static bool framebuffers = false;
+
+static void *
+_proc(const char *name, const char *suffix)
+{
+	char full[64];
+	sprintf(full, "%s%s", name, suffix);
+	return render_proc_address(full);
+}
+
+static bool
+_load_framebuffers(const char *suffix)
+{
+	gen_framebuffers         = (GenFramebuffersProc)_proc("glGenFramebuffers", suffix);
+	delete_framebuffers      = (DeleteFramebuffersProc)_proc("glDeleteFramebuffers", suffix);
+	bind_framebuffer         = (BindFramebufferProc)_proc("glBindFramebuffer", suffix);
+	framebuffer_texture_2d   = (FramebufferTexture2DProc)_proc("glFramebufferTexture2D", suffix);
+	check_framebuffer_status = (CheckFramebufferStatusProc)_proc("glCheckFramebufferStatus", suffix);
+	gen_renderbuffers        = (GenRenderbuffersProc)_proc("glGenRenderbuffers", suffix);
+	delete_renderbuffers     = (DeleteRenderbuffersProc)_proc("glDeleteRenderbuffers", suffix);
+	bind_renderbuffer        = (BindRenderbufferProc)_proc("glBindRenderbuffer", suffix);
+	renderbuffer_storage     = (RenderbufferStorageProc)_proc("glRenderbufferStorage", suffix);
+	framebuffer_renderbuffer = (FramebufferRenderbufferProc)_proc("glFramebufferRenderbuffer", suffix);
+	return gen_framebuffers && delete_framebuffers && bind_framebuffer
+		&& framebuffer_texture_2d && check_framebuffer_status
+		&& gen_renderbuffers && delete_renderbuffers && bind_renderbuffer
+		&& renderbuffer_storage && framebuffer_renderbuffer;
+}
+
+void
+layer_init(void)
+{
+	framebuffers = false;
+	blend_func_separate = NULL;
+
+	// Replays have neither: captures draw every layer directly
+	if(gltrace_on)
+		return;
+
+	if(render_gl_version() >= 30 || render_has_extension("GL_ARB_framebuffer_object"))
+		framebuffers = _load_framebuffers("");
+	if(!framebuffers && render_has_extension("GL_EXT_framebuffer_object"))
+		framebuffers = _load_framebuffers("EXT");
+
+	if(render_gl_version() >= 14)
+		blend_func_separate = (BlendFuncSeparateProc)render_proc_address("glBlendFuncSeparate");
+	if(!blend_func_separate && render_has_extension("GL_EXT_blend_func_separate"))
+		blend_func_separate = (BlendFuncSeparateProc)render_proc_address("glBlendFuncSeparateEXT");
+
+	if(!framebuffers)
+		log_info("layer: no framebuffer objects, caching through the back buffer");
+}
+
+bool
+layer_framebuffers(void)
+{
+	return framebuffers;
+}
+
+unsigned int
+layer_target_create(unsigned int texture, int width, int height, unsigned int *depth)
+{
+	if(depth)
+		*depth = 0;
+	if(!framebuffers)
+		return 0;
+
+	GLuint framebuffer = 0, renderbuffer = 0;
+	GLuint previous = layer_target_bind(0);
+	gen_framebuffers(1, &framebuffer);
+	bind_framebuffer(LAYER_FRAMEBUFFER, framebuffer);
+	framebuffer_texture_2d(LAYER_FRAMEBUFFER, LAYER_COLOR_ATTACHMENT0,
+	                       GL_TEXTURE_2D, texture, 0);
+	if(depth) {
+		gen_renderbuffers(1, &renderbuffer);
+		bind_renderbuffer(LAYER_RENDERBUFFER, renderbuffer);
+		renderbuffer_storage(LAYER_RENDERBUFFER, LAYER_DEPTH_COMPONENT24, width, height);
+		bind_renderbuffer(LAYER_RENDERBUFFER, 0);
+		framebuffer_renderbuffer(LAYER_FRAMEBUFFER, LAYER_DEPTH_ATTACHMENT,
+		                         LAYER_RENDERBUFFER, renderbuffer);
+	}
+	GLenum status = check_framebuffer_status(LAYER_FRAMEBUFFER);
+	layer_target_bind(previous);
+
+	if(status != LAYER_FRAMEBUFFER_COMPLETE) {
+		log_warn("layer: framebuffer incomplete (0x%x)", (unsigned int)status);
+		layer_target_free(framebuffer, renderbuffer);
+		return 0;
+	}
+	if(depth)
+		*depth = renderbuffer;
+	return framebuffer;
+}
+
+void
+layer_target_free(unsigned int framebuffer, unsigned int depth)
+{
+	GLuint names[2] = { framebuffer, depth };
+	if(names[0])
+		delete_framebuffers(1, &names[0]);
+	if(names[1])
+		delete_renderbuffers(1, &names[1]);
+}
+
+unsigned int
+layer_target_bind(unsigned int framebuffer)
+{
+	GLint previous = 0;
+	glGetIntegerv(LAYER_FRAMEBUFFER_BINDING, &previous);
+	bind_framebuffer(LAYER_FRAMEBUFFER, framebuffer);
+	return (unsigned int)previous;
+}
+
+void
+layer_cache_init(LayerCache *layer, LayerMode mode, LayerDrawFunc draw, void *data)
+{
+	layer->mode        = mode;
+	layer->draw        = draw;
+	layer->data        = data;
+	layer->texture     = 0;
+	layer->framebuffer = 0;
+	layer->texture_w   = layer->texture_h = 0;
+	layer->width       = layer->height = 0;
+	layer->view_x      = layer->view_y = 0.0f;
+	layer->valid       = false;
+	layer->redraws     = 0;
+}
+
+void
+layer_cache_free(LayerCache *layer)
+{
+	if(layer->framebuffer)
+		layer_target_free(layer->framebuffer, 0);
+	if(layer->texture)
+		free_texture(layer->texture);
+	layer->framebuffer = 0;
+	layer->texture = 0;
+	layer->texture_w = layer->texture_h = 0;
+	layer->valid = false;
+}
+
+void
+layer_cache_invalidate(LayerCache *layer)
+{
+	layer->valid = false;
+}
+
+void
+layer_cache_set_view(LayerCache *layer, float x, float y)
+{
+	if(x != layer->view_x || y != layer->view_y) {
+		layer->view_x = x;
+		layer->view_y = y;
+		layer->valid = false;
+	}
+}
+
+static int
+_power_of_two(int size)
+{
+	int p = 1;
+	while(p < size)
+		p <<= 1;
+	return p;
+}
+
+// Power of two sized, so the copy path works on GL 1.1 too
+static void
+_allocate(LayerCache *layer, int width, int height)
+{
+	int tw = _power_of_two(width), th = _power_of_two(height);
+	if(tw == layer->texture_w && th == layer->texture_h)
+		return;
+
+	GLuint texture = layer->texture;
+	if(texture)
+		free_texture(texture);
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tw, th, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	track_texture(texture, (unsigned long)tw * th * 4);
+
+	layer->texture = texture;
+	layer->texture_w = tw;
+	layer->texture_h = th;
+
+	if(!framebuffers)
+		return;
+
+	if(layer->framebuffer)
+		layer_target_free(layer->framebuffer, 0);
+	layer->framebuffer = layer_target_create(texture, tw, th, NULL);
+	if(!layer->framebuffer) {
+		log_warn("layer: caching through the back buffer");
+		framebuffers = false;
+	}
+}
+
+static void
+_render(LayerCache *layer, const GLint *viewport)
+{
+	if(framebuffers) {
+		GLfloat clear[4];
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, clear);
+
+		GLuint previous = layer_target_bind(layer->framebuffer);
+		glViewport(0, 0, viewport[2], viewport[3]);
+		if(layer->mode == LAYER_OPAQUE)
+			glClearColor(clear[0], clear[1], clear[2], 1.0f);
+		else glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		// Accumulate coverage in alpha, colors end up premultiplied
+		if(layer->mode == LAYER_TRANSLUCENT)
+			blend_func_separate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+			                    GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		layer->draw(layer->data);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		layer_target_bind(previous);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		glClearColor(clear[0], clear[1], clear[2], clear[3]);
+	} else {
+		// Drawn over the cleared frame, copied out, then cleared again
+		layer->draw(layer->data);
+		glBindTexture(GL_TEXTURE_2D, layer->texture);
+		glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, viewport[0], viewport[1],
+		                    viewport[2], viewport[3]);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	}
+
+	layer->valid = true;
+	layer->redraws++;
+}
+
+void
+layer_cache_draw(LayerCache *layer)
+{
+	bool cacheable = !gltrace_on && (layer->mode == LAYER_OPAQUE
+		|| (framebuffers && blend_func_separate));
+	if(!cacheable) {
+		layer->draw(layer->data);
+		return;
+	}
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if(viewport[2] != layer->width || viewport[3] != layer->height) {
+		_allocate(layer, viewport[2], viewport[3]);
+		layer->width = viewport[2];
+		layer->height = viewport[3];
+		layer->valid = false;
+	}
+	if(!layer->valid)
+		_render(layer, viewport);
+
+	float u = (float)layer->width / layer->texture_w;
+	float v = (float)layer->height / layer->texture_h;
+
+	glDisable(GL_DEPTH_TEST);
+	if(layer->mode == LAYER_OPAQUE)
+		glDisable(GL_BLEND);
+	else glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, layer->texture);
+	glLoadIdentity();
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	glBegin(GL_QUADS);
+		glTexCoord2f(0.0f, 0.0f);
+		glVertex2f(-1.0f, -1.0f);
+		glTexCoord2f(u, 0.0f);
+		glVertex2f(1.0f, -1.0f);
+		glTexCoord2f(u, v);
+		glVertex2f(1.0f, 1.0f);
+		glTexCoord2f(0.0f, v);
+		glVertex2f(-1.0f, 1.0f);
+	glEnd();
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_DEPTH_TEST);
+}
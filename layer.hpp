@@ -0,0 +1,59 @@
+#ifndef LAYER_HPP_INCLUDED
+#define LAYER_HPP_INCLUDED
+
+// Render-to-texture caches for layers that rarely change. A layer is
+// drawn by its callback into a texture the size of the viewport, then
+// composited every frame as one quad until it is invalidated, either
+// explicitly when its contents change or by a new view key or
+// viewport size.
+//
+// Layers render through a framebuffer object (GL 3.0 or
+// EXT_framebuffer_object) when there is one, otherwise into the back
+// buffer, which is copied out with glCopyTexSubImage2D and cleared:
+// without an FBO a layer must be the first thing drawn in the frame.
+//
+// Opaque layers replace whatever is under them, like a clear.
+// Translucent layers are stored premultiplied, so callbacks must leave
+// the blend function alone; they need an FBO and are drawn directly
+// every frame without one. Layers have no depth buffer.
+
+enum LayerMode
+{
+	LAYER_OPAQUE,
+	LAYER_TRANSLUCENT
+};
+
+typedef void (*LayerDrawFunc)(void *data);
+
+struct LayerCache
+{
+	LayerMode     mode;
+	LayerDrawFunc draw;
+	void         *data;
+	unsigned int  texture;
+	unsigned int  framebuffer;
+	int           texture_w, texture_h;
+	int           width, height; // Viewport it was drawn for
+	float         view_x, view_y;
+	bool          valid;
+	unsigned int  redraws;       // Times the callback ran
+};
+
+void layer_init(void); // Called by render_init
+bool layer_framebuffers(void);
+
+// Framebuffer objects for other offscreen targets, drawing into a
+// texture, with a 24 bit depth buffer when depth is not NULL. Returns
+// 0 without FBO support or when the result is incomplete.
+unsigned int layer_target_create(unsigned int texture, int width, int height,
+                                 unsigned int *depth);
+void         layer_target_free(unsigned int framebuffer, unsigned int depth);
+unsigned int layer_target_bind(unsigned int framebuffer); // Returns the previous one
+
+void layer_cache_init(LayerCache *layer, LayerMode mode, LayerDrawFunc draw, void *data);
+void layer_cache_free(LayerCache *layer);
+void layer_cache_invalidate(LayerCache *layer);
+void layer_cache_set_view(LayerCache *layer, float x, float y); // Invalidates on change
+void layer_cache_draw(LayerCache *layer);
+
+#endif // LAYER_HPP_INCLUDED
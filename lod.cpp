@@ -0,0 +1,119 @@
+#include "lod.hpp"
+#include <cmath>
+#include <GL/gl.h>
+
+#define LOD_PI 3.14159265f
+
+// Multiples of 6 so that six-color patterns wrap around evenly
+static const int level_segments[LOD_CIRCLE_LEVELS] = {
+	6, 12, 18, 24, 36, 48, 72, 96, 144, 192
+};
+
+// Going down a level needs that much slack, to avoid popping
+// back and forth when the radius sits on a boundary.
+static const float hysteresis = 0.2f;
+
+static float max_error = 0.5f;
+
+// (cos, sin) pairs, segments + 1 entries so fans close themselves
+static float circle_tables[LOD_CIRCLE_LEVELS][(192 + 1) * 2];
+
+static float proj[16];
+static float half_width = 1.0f;
+
+void
+lod_init(void)
+{
+	for(int l = 0; l < LOD_CIRCLE_LEVELS; l++) {
+		int n = level_segments[l];
+		for(int i = 0; i <= n; i++) {
+			float a = (2.0f * LOD_PI * (i % n)) / n;
+			circle_tables[l][i * 2]     = cosf(a);
+			circle_tables[l][i * 2 + 1] = sinf(a);
+		}
+	}
+}
+
+void
+lod_begin_frame(void)
+{
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetFloatv(GL_PROJECTION_MATRIX, proj);
+	half_width = viewport[2] * 0.5f;
+}
+
+void
+lod_set_max_error(float pixels)
+{
+	max_error = pixels > 0.01f ? pixels : 0.01f;
+}
+
+float
+lod_get_max_error(void)
+{
+	return max_error;
+}
+
+float
+lod_pixel_radius(const float *center, float radius)
+{
+	float w = proj[3] * center[0] + proj[7] * center[1]
+		+ proj[11] * center[2] + proj[15];
+	if(w <= 0.0001f)
+		return 0.0f;
+	return radius * proj[0] / w * half_width;
+}
+
+static int
+_required_segments(float pixel_radius)
+{
+	if(pixel_radius <= max_error)
+		return 0;
+
+	// Chord error of an n-gon is r * (1 - cos(pi / n))
+	float half_angle = acosf(1.0f - max_error / pixel_radius);
+	return (int)ceilf(LOD_PI / half_angle);
+}
+
+int
+lod_circle_select(CircleLod *lod, float pixel_radius)
+{
+	int needed = _required_segments(pixel_radius);
+	int level = lod->level;
+
+	if(level < 0 || level >= LOD_CIRCLE_LEVELS)
+		level = 0;
+
+	while(level < LOD_CIRCLE_LEVELS - 1 && level_segments[level] < needed)
+		level++;
+
+	while(level > 0 &&
+	      level_segments[level - 1] * (1.0f - hysteresis) >= needed)
+		level--;
+
+	lod->level = level;
+	return level;
+}
+
+int
+lod_circle_level(float pixel_radius)
+{
+	int needed = _required_segments(pixel_radius);
+	int level = 0;
+	while(level < LOD_CIRCLE_LEVELS - 1 && level_segments[level] < needed)
+		level++;
+	return level;
+}
+
+int
+lod_circle_segments(int level)
+{
+	return level_segments[level];
+}
+
+const float *
+lod_circle_table(int level)
+{
+	return circle_tables[level];
+}
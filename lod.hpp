@@ -0,0 +1,26 @@
+#ifndef LOD_HPP_INCLUDED
+#define LOD_HPP_INCLUDED
+
+// Level of detail for circles and discs. Segment counts are
+// picked from the projected radius in pixels so that the chord
+// error stays under a configurable amount of pixels. Unit circle
+// tables for every level are built once on init.
+
+#define LOD_CIRCLE_LEVELS 10
+
+struct CircleLod
+{
+	int level;
+};
+
+void         lod_init(void);
+void         lod_begin_frame(void);
+void         lod_set_max_error(float pixels);
+float        lod_get_max_error(void);
+float        lod_pixel_radius(const float *center, float radius);
+int          lod_circle_select(CircleLod *lod, float pixel_radius);
+int          lod_circle_level(float pixel_radius); // No hysteresis
+int          lod_circle_segments(int level);
+const float *lod_circle_table(int level);
+
+#endif // LOD_HPP_INCLUDED
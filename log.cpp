@@ -0,0 +1,402 @@
+#include "log.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#define snprintf _snprintf
+#define LOG_THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+#include <time.h>
+#define LOG_THREAD_LOCAL __thread
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define LOG_TSC 1
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define LOG_TSC 1
+#endif
+
+#include "atomic.hpp"
+#include "fps.hpp"
+
+#define LOG_RING_RECORDS 1024 // Per thread, power of two
+#define LOG_POLL_MS      5
+#define LOG_LINE_BYTES   512
+
+struct LogRecord
+{
+	double        stamp; // Raw counter, see _stamp
+	const char   *format;
+	unsigned char level;
+	unsigned char types[LOG_MAX_ARGS];
+	union {
+		int          i;
+		unsigned int u;
+		double       d;
+		unsigned int offset; // Into text, for strings
+	} values[LOG_MAX_ARGS];
+	char          text[LOG_TEXT_BYTES];
+};
+
+// Single producer (the owning thread), single consumer (the writer)
+struct LogRing
+{
+	LogRecord             records[LOG_RING_RECORDS];
+	volatile unsigned int head; // Next record to write
+	volatile unsigned int tail; // Next record to format
+	volatile unsigned int dropped;
+	LogRing              *next;
+};
+
+static const char *level_names[] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+
+static LOG_THREAD_LOCAL LogRing *thread_ring = NULL;
+static LogRing *volatile rings     = NULL;
+static LogLevel          min_level = LOG_DEBUG;
+static volatile bool     running   = false;
+static volatile bool     stopping  = false;
+
+#ifdef _WIN32
+static HANDLE    writer;
+#else
+static pthread_t writer;
+#endif
+
+// Records are stamped with the TSC where there is one, which is much
+// cheaper than the clock. The writer maps stamps to getElapsedTime
+// seconds with a rate measured against the clock since log_init.
+static double base_stamp = 0.0;
+static double base_time  = 0.0;
+static double stamp_rate = 0.0; // Stamps per second, 0 until measured
+
+static inline double
+_stamp(void)
+{
+#ifdef LOG_TSC
+	return (double)__rdtsc();
+#else
+	return getElapsedTime();
+#endif
+}
+
+static void
+_calibrate(void)
+{
+#ifdef LOG_TSC
+	double stamp = _stamp(), now = getElapsedTime();
+	if(now - base_time > 0.001)
+		stamp_rate = (stamp - base_stamp) / (now - base_time);
+#else
+	stamp_rate = 1.0;
+#endif
+}
+
+static double
+_seconds(double stamp)
+{
+	if(stamp_rate <= 0.0)
+		return base_time;
+	return base_time + (stamp - base_stamp) / stamp_rate;
+}
+
+static LogRing *
+_thread_ring(void)
+{
+	LogRing *ring = (LogRing*)calloc(1, sizeof(LogRing));
+	LogRing *head;
+	do {
+		head = rings;
+		ring->next = head;
+	} while(!atomic_cas_ptr((void *volatile*)&rings, head, ring));
+	thread_ring = ring;
+	return ring;
+}
+
+static void
+_capture(LogRecord *rec, LogLevel level, const char *format,
+         const LogArg **args)
+{
+	unsigned int used = 0;
+
+	rec->stamp = _stamp();
+	rec->format = format;
+	rec->level = (unsigned char)level;
+	for(int i = 0; i < LOG_MAX_ARGS; i++) {
+		const LogArg &arg = *args[i];
+		rec->types[i] = (unsigned char)arg.type;
+		switch(arg.type) {
+		case LOG_ARG_INT:    rec->values[i].i = arg.i; break;
+		case LOG_ARG_UINT:   rec->values[i].u = arg.u; break;
+		case LOG_ARG_DOUBLE: rec->values[i].d = arg.d; break;
+		case LOG_ARG_STRING: {
+			const char *s = arg.s ? arg.s : "(null)";
+			rec->values[i].offset = used;
+			while(*s && used < LOG_TEXT_BYTES - 1)
+				rec->text[used++] = *s++;
+			rec->text[used] = '\0';
+			if(used < LOG_TEXT_BYTES - 1)
+				used++;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+static int
+_as_int(const LogRecord *rec, int arg)
+{
+	switch(rec->types[arg]) {
+	case LOG_ARG_UINT:   return (int)rec->values[arg].u;
+	case LOG_ARG_DOUBLE: return (int)rec->values[arg].d;
+	case LOG_ARG_INT:    return rec->values[arg].i;
+	default:             return 0;
+	}
+}
+
+static double
+_as_double(const LogRecord *rec, int arg)
+{
+	switch(rec->types[arg]) {
+	case LOG_ARG_INT:    return rec->values[arg].i;
+	case LOG_ARG_UINT:   return rec->values[arg].u;
+	case LOG_ARG_DOUBLE: return rec->values[arg].d;
+	default:             return 0.0;
+	}
+}
+
+// Formats one record with printf rules, converting each argument to
+// the type its conversion expects. Missing arguments, and conversions
+// taking their width or precision from an argument, print as "?".
+static void
+_format(const LogRecord *rec, double seconds, char *out, int size)
+{
+	static const char *conversions = "diouxXeEfgGcs";
+	const char *f = rec->format;
+	int arg = 0;
+	int len = snprintf(out, size, "%9.3f %s ", seconds, level_names[rec->level]);
+
+	while(*f && len < size - 1) {
+		if(*f != '%' || f[1] == '%') {
+			out[len++] = *f;
+			f += (*f == '%') ? 2 : 1;
+			continue;
+		}
+
+		// Length modifiers are dropped: the argument is passed to
+		// snprintf already widened by _as_int or _as_double
+		char spec[32];
+		int n = 0;
+		bool star = false;
+		spec[n++] = *f++;
+		while(*f && n < 30 && !strchr(conversions, *f)) {
+			if(*f == '*') {
+				star = true;
+				arg++; // Its own argument
+			}
+			if(!strchr("hlLqjzt", *f))
+				spec[n++] = *f;
+			f++;
+		}
+		if(!*f)
+			break;
+		spec[n++] = *f++;
+		spec[n] = '\0';
+
+		int room = size - len, written;
+		bool missing = (arg >= LOG_MAX_ARGS || rec->types[arg] == LOG_ARG_NONE);
+		if(missing || star) {
+			written = snprintf(out + len, room, "?");
+		} else {
+			switch(spec[n - 1]) {
+			case 'd': case 'i': case 'c':
+				written = snprintf(out + len, room, spec, _as_int(rec, arg));
+				break;
+			case 'o': case 'u': case 'x': case 'X':
+				written = snprintf(out + len, room, spec, (unsigned int)_as_int(rec, arg));
+				break;
+			case 's':
+				written = snprintf(out + len, room, spec,
+					rec->types[arg] == LOG_ARG_STRING
+						? rec->text + rec->values[arg].offset : "?");
+				break;
+			default:
+				written = snprintf(out + len, room, spec, _as_double(rec, arg));
+				break;
+			}
+		}
+		arg++;
+
+		if(written < 0 || written >= room) {
+			len = size - 1;
+			break;
+		}
+		len += written;
+	}
+	out[len] = '\0';
+}
+
+static void
+_write(const LogRecord *rec, double seconds)
+{
+	char line[LOG_LINE_BYTES];
+	_format(rec, seconds, line, LOG_LINE_BYTES - 1);
+	FILE *out = rec->level >= LOG_WARN ? stderr : stdout;
+	fputs(line, out);
+	fputc('\n', out);
+}
+
+// Formats everything queued so far; returns the records written
+static int
+_drain(void)
+{
+	int written = 0;
+	_calibrate();
+	for(LogRing *ring = rings; ring; ring = ring->next) {
+		unsigned int head = atomic_load_acquire(&ring->head);
+		unsigned int tail = ring->tail;
+		while(tail != head) {
+			const LogRecord *rec = &ring->records[tail & (LOG_RING_RECORDS - 1)];
+			_write(rec, _seconds(rec->stamp));
+			tail++;
+			written++;
+		}
+		atomic_store_release(&ring->tail, tail);
+	}
+	if(written) {
+		fflush(stdout);
+		fflush(stderr);
+	}
+	return written;
+}
+
+static void
+_sleep(int ms)
+{
+#ifdef _WIN32
+	Sleep(ms);
+#else
+	struct timespec t;
+	t.tv_sec = 0;
+	t.tv_nsec = ms * 1000000L;
+	nanosleep(&t, NULL);
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+_writer(LPVOID data)
+#else
+static void *
+_writer(void *data)
+#endif
+{
+	while(!stopping) {
+		if(!_drain())
+			_sleep(LOG_POLL_MS);
+	}
+	_drain();
+	return 0;
+}
+
+static void
+_at_exit(void)
+{
+	log_shutdown();
+}
+
+void
+log_init(void)
+{
+	if(running)
+		return;
+
+	base_time = getElapsedTime();
+	base_stamp = _stamp();
+	stamp_rate = 0.0;
+
+	stopping = false;
+#ifdef _WIN32
+	writer = CreateThread(NULL, 0, _writer, NULL, 0, NULL);
+	running = (writer != NULL);
+#else
+	running = (pthread_create(&writer, NULL, _writer, NULL) == 0);
+#endif
+
+	// exit() from the key handler must not lose queued records
+	static bool registered = false;
+	if(!registered) {
+		atexit(_at_exit);
+		registered = true;
+	}
+}
+
+void
+log_shutdown(void)
+{
+	if(!running)
+		return;
+
+	stopping = true;
+#ifdef _WIN32
+	WaitForSingleObject(writer, INFINITE);
+	CloseHandle(writer);
+#else
+	pthread_join(writer, NULL);
+#endif
+	running = false;
+
+	unsigned int dropped = log_dropped();
+	if(dropped)
+		fprintf(stderr, "log: %u records dropped, rings were full\n", dropped);
+}
+
+void
+log_set_level(LogLevel level)
+{
+	min_level = level;
+}
+
+unsigned int
+log_dropped(void)
+{
+	unsigned int dropped = 0;
+	for(LogRing *ring = rings; ring; ring = ring->next)
+		dropped += ring->dropped;
+	return dropped;
+}
+
+void
+log_write(LogLevel level, const char *format,
+          const LogArg &a0, const LogArg &a1, const LogArg &a2,
+          const LogArg &a3, const LogArg &a4, const LogArg &a5)
+{
+	const LogArg *args[LOG_MAX_ARGS] = { &a0, &a1, &a2, &a3, &a4, &a5 };
+
+	if(level < min_level)
+		return;
+
+	if(!running) {
+		LogRecord rec;
+		_capture(&rec, level, format, args);
+		_write(&rec, getElapsedTime());
+		fflush(rec.level >= LOG_WARN ? stderr : stdout);
+		return;
+	}
+
+	LogRing *ring = thread_ring ? thread_ring : _thread_ring();
+	unsigned int head = ring->head;
+	if(head - atomic_load_acquire(&ring->tail) >= LOG_RING_RECORDS) {
+		ring->dropped++;
+		return;
+	}
+
+	_capture(&ring->records[head & (LOG_RING_RECORDS - 1)], level, format, args);
+	atomic_store_release(&ring->head, head + 1);
+}
@@ -0,0 +1,100 @@
+#ifndef LOG_HPP_INCLUDED
+#define LOG_HPP_INCLUDED
+
+// Asynchronous logger. log_* calls copy a binary record (timestamp,
+// level, format, arguments) into a lock-free ring owned by the calling
+// thread and return; a background thread formats the records with
+// printf rules and writes them out. A full ring drops the record
+// rather than block. Before log_init, and after log_shutdown, records
+// are formatted and written on the spot.
+//
+// The format pointer is the record's format id and is kept as is, so
+// it must be a string literal. String arguments are copied, up to
+// LOG_TEXT_BYTES in total per record. Arguments are stored as int,
+// unsigned int or double, so length modifiers (%ld, %zu...) are
+// ignored; a * width or precision prints as "?".
+
+#define LOG_MAX_ARGS   6
+#define LOG_TEXT_BYTES 64
+
+enum LogLevel
+{
+	LOG_DEBUG,
+	LOG_INFO,
+	LOG_WARN,
+	LOG_ERROR
+};
+
+enum LogArgType
+{
+	LOG_ARG_NONE,
+	LOG_ARG_INT,
+	LOG_ARG_UINT,
+	LOG_ARG_DOUBLE,
+	LOG_ARG_STRING
+};
+
+struct LogArg
+{
+	LogArgType type;
+	union {
+		int          i;
+		unsigned int u;
+		double       d;
+		const char  *s;
+	};
+
+	LogArg(void)              : type(LOG_ARG_NONE)   { d = 0.0; }
+	LogArg(int value)         : type(LOG_ARG_INT)    { i = value; }
+	LogArg(unsigned int value): type(LOG_ARG_UINT)   { u = value; }
+	LogArg(double value)      : type(LOG_ARG_DOUBLE) { d = value; }
+	LogArg(const char *value) : type(LOG_ARG_STRING) { s = value; }
+};
+
+void         log_init(void);     // Starts the writer thread
+void         log_shutdown(void); // Drains every ring and stops the thread
+void         log_set_level(LogLevel level);
+unsigned int log_dropped(void);
+
+void log_write(LogLevel level, const char *format,
+               const LogArg &a0 = LogArg(), const LogArg &a1 = LogArg(),
+               const LogArg &a2 = LogArg(), const LogArg &a3 = LogArg(),
+               const LogArg &a4 = LogArg(), const LogArg &a5 = LogArg());
+
+static inline void
+log_debug(const char *format,
+          const LogArg &a0 = LogArg(), const LogArg &a1 = LogArg(),
+          const LogArg &a2 = LogArg(), const LogArg &a3 = LogArg(),
+          const LogArg &a4 = LogArg(), const LogArg &a5 = LogArg())
+{
+	log_write(LOG_DEBUG, format, a0, a1, a2, a3, a4, a5);
+}
+
+static inline void
+log_info(const char *format,
+         const LogArg &a0 = LogArg(), const LogArg &a1 = LogArg(),
+         const LogArg &a2 = LogArg(), const LogArg &a3 = LogArg(),
+         const LogArg &a4 = LogArg(), const LogArg &a5 = LogArg())
+{
+	log_write(LOG_INFO, format, a0, a1, a2, a3, a4, a5);
+}
+
+static inline void
+log_warn(const char *format,
+         const LogArg &a0 = LogArg(), const LogArg &a1 = LogArg(),
+         const LogArg &a2 = LogArg(), const LogArg &a3 = LogArg(),
+         const LogArg &a4 = LogArg(), const LogArg &a5 = LogArg())
+{
+	log_write(LOG_WARN, format, a0, a1, a2, a3, a4, a5);
+}
+
+static inline void
+log_error(const char *format,
+          const LogArg &a0 = LogArg(), const LogArg &a1 = LogArg(),
+          const LogArg &a2 = LogArg(), const LogArg &a3 = LogArg(),
+          const LogArg &a4 = LogArg(), const LogArg &a5 = LogArg())
+{
+	log_write(LOG_ERROR, format, a0, a1, a2, a3, a4, a5);
+}
+
+#endif // LOG_HPP_INCLUDED
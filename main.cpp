@@ -1,65 +1,170 @@
-#include <iostream>
-#include <iomanip>
-#include <sstream>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <GL/glut.h>
 #include <GL/gl.h>
+#ifdef FREEGLUT
+#include <GL/freeglut_ext.h>
+#endif
 
 #include "fps.hpp"
 #include "keyboard.hpp"
 #include "render.hpp"
 #include "utils.hpp"
 #include "scene.hpp"
+#include "mesh.hpp"
+#include "bench.hpp"
+#include "replay.hpp"
+#include "latency.hpp"
+#include "gltrace.hpp"
+#include "overdraw.hpp"
+#include "log.hpp"
+#include "memory.hpp"
+#include "profile.hpp"
+#include "hud.hpp"
+#include "telemetry.hpp"
+#include "timer.hpp"
+#include "shader.hpp"
+#include "dynres.hpp"
+#include "quality.hpp"
+#include "glstats.hpp"
 
 // Window stuff
-static std::string windowTitle;
 #define WINW 500
 #define WINH 500
 
-void
-update(void)
-{
-	static int oldTime = 0;
-	fpsUpdate();
-	double dt = getDeltaTime();
+// No window nor GLUT when running offscreen benchmarks
+static bool headless = false;
+
+// Simulation ticks, one per displayed frame
+static unsigned int tick = 0;
 
-	scene_update(dt);
+// Sample input again between update and draw
+static bool late_latch = false;
 
-	/* FPS information on title */
-	int currTime = glutGet(GLUT_ELAPSED_TIME);
-	if(currTime - oldTime > 2000) { // Every 2s
-		std::ostringstream oss;
+// GL command capture, GLSTATS builds only
+static const char *capture_path   = NULL;
+static int         capture_frames = 300;
 
-		double fps = getFps();
+// Extra live particles, for stress tests
+static int particle_stress = 0;
 
-		oss.clear();
-		oss << "MyGame | FPS: "
-			<< std::setw(2)
-			<< getFps();
-		windowTitle = oss.str();
-		oldTime = currTime;
+// Collision broadphase benchmark instead of the scene, see bench.hpp
+static int spatial_bodies = 0;
 
-		std::cout << "FPS: " << fps << std::endl;
+// Allocations are reported from this tick on, see memory.hpp
+#define STEADY_STATE_TICK 120
+static MemStrict alloc_strict = MEM_STRICT_OFF;
+
+/* FPS information on title */
+static void
+update_title(void *data)
+{
+	double fps = getFps();
 
-		glutSetWindowTitle(windowTitle.c_str());
+	if(overdraw_enabled()) {
+		OverdrawStats overdraw;
+		overdraw_last(&overdraw);
+		log_info("FPS: %.1f | Mesh triangles: %d | Overdraw avg: %.2f covered: %.2f max: %d",
+		         fps, mesh_triangles_submitted(), overdraw.average,
+		         overdraw.average_covered, overdraw.max);
+	} else {
+		log_info("FPS: %.1f | Mesh triangles: %d", fps, mesh_triangles_submitted());
 	}
 
-	glutPostRedisplay();
+	glutSetWindowTitle(mem_frame_printf("MyGame | FPS: %2g", fps));
+}
+
+void
+update(void)
+{
+	static int input_zone = profile_zone("input");
+	static int scene_zone = profile_zone("scene_update");
+	fpsUpdate();
+	timer_advance(getFrameClock());
+	double dt = getDeltaTime();
+
+	tick++;
+	if(tick == STEADY_STATE_TICK)
+		mem_set_strict(alloc_strict);
+
+	{
+		ProfileScope scope(input_zone);
+		replay_feed();
+		kbdLatch();
+		latency_consume(tick);
+		replay_tick();
+	}
+	{
+		ProfileScope scope(scene_zone);
+		scene_update(dt);
+	}
 }
 
 void
 draw(void)
 {
+	static int draw_zone = profile_zone("scene_draw");
+	static int present_zone = profile_zone("present");
+
+	dynres_begin();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	overdraw_begin_frame();
+
+	if(late_latch) {
+#ifdef FREEGLUT
+		// Dispatch key events that arrived during update. Expose or
+		// reshape events can run display() from in here; the guard in
+		// display() turns that into a redisplay request.
+		if(!headless)
+			glutMainLoopEvent();
+#endif
+		scene_late_latch();
+	}
+
+	profile_begin(draw_zone);
 	scene_draw();
-	glutSwapBuffers();
+	overdraw_end_frame();
+	dynres_end();
+	profile_end();
+
+	scene_draw_bounds();
+	hud_draw();
+
+	profile_begin(present_zone);
+	if(!headless)
+		glutSwapBuffers();
+
+	// Wait for the frame to be out before timestamping it
+	if(latency_enabled()) {
+		glFinish();
+		latency_present(tick);
+	}
+	profile_end();
+
+	glstats_frame();
+	gltrace_frame();
+	mem_frame();
+	profile_frame();
+	telemetry_frame();
+	quality_frame();
 }
 
 void
 display(void)
 {
+	// Nested from the late latch event pump, mid-frame
+	static bool in_display = false;
+	if(in_display) {
+		glutPostRedisplay();
+		return;
+	}
+
+	in_display = true;
 	update();
 	draw();
+	in_display = false;
+	glutPostRedisplay();
 }
 
 inline void
@@ -69,39 +174,55 @@ keyHandle(unsigned char key, bool pressed)
 		goto app_exit;
 	}
 
-	unsigned int btn;
-
-	switch(key) {
-	case 'w': case 'W':
-		btn = BTN_UP;
-		break;
-	case 'a': case 'A':
-		btn = BTN_LEFT;
-		break;
-	case 's': case 'S':
-		btn = BTN_DOWN;
-		break;
-	case 'd': case 'D':
-		btn = BTN_RIGHT;
-		break;
-	case 'k': case 'K':
-		btn = BTN_ACTION1;
-		break;
-	case 'i': case 'I':
-		btn = BTN_ACTION2;
-		break;
-	case 10:
-		btn = BTN_START;
-		break;
-	default:
-		return; // Do not process further
-	}
-
-	kbdUpdateButton(btn, pressed);
+	// Debug view toggles, not game buttons
+	if(pressed && key == 'o') {
+		overdraw_enable(!overdraw_enabled());
+		return;
+	}
+	if(pressed && key == 'h') {
+		hud_enable(!hud_enabled());
+		return;
+	}
+	if(pressed && key == 'b') {
+		scene_show_bounds(!scene_bounds_shown());
+		return;
+	}
+	if(pressed && key == 'm') {
+		scene_show_tilemap(!scene_tilemap_shown());
+		return;
+	}
+	if(pressed && key == 'g') {
+		shader_enable(!shader_enabled());
+		return;
+	}
+	if(pressed && key == 'r') {
+		dynres_enable(!dynres_enabled());
+		return;
+	}
+	if(pressed && key == 'q') {
+		quality_enable(!quality_enabled());
+		return;
+	}
+
+	// Recorded input drives the buttons while replaying
+	if(replay_active())
+		return;
+
+	kbdKeyEvent(key, pressed);
 	return;
 
 app_exit:
+	log_shutdown(); // Queued lines go out before the report
+	if(latency_enabled()) {
+		printf("Latency: ");
+		latency_write_json(stdout, "");
+		printf("\n");
+	}
 	scene_dispose();
+	replay_close();
+	overdraw_dispose();
+	hud_dispose();
+	dynres_dispose();
 	exit(0);
 }
 
@@ -117,13 +238,118 @@ keyUp(unsigned char key, int x, int y)
 	keyHandle(key, false);
 }
 
+static int
+run_bench(const BenchOptions *options)
+{
+	headless = true;
+	if(!bench_init(options))
+		return 1;
+
+	if(capture_path && !gltrace_begin(capture_path, capture_frames,
+	                                  options->width, options->height))
+		return 1;
+
+	render_init();
+	hud_init();
+	scene_init();
+	scene_set_particle_stress(particle_stress);
+
+	for(int i = 0; i < options->frames; i++) {
+		bench_frame_begin(i);
+		update();
+		draw();
+		bench_frame_end();
+	}
+
+	bench_report();
+	scene_dispose();
+	replay_close();
+	overdraw_dispose();
+	hud_dispose();
+	dynres_dispose();
+	bench_dispose();
+	return 0;
+}
+
 int
 main(int argc, char **argv)
 {
+	log_init();
 	kbdInit();
 
+	BenchOptions bench;
+	bool bench_mode = false;
+	bench_default_options(&bench);
+
+	for(int i = 1; i < argc; i++) {
+		bool has_value = (i + 1 < argc);
+		if(!strcmp(argv[i], "--bench")) {
+			bench_mode = true;
+		} else if(!strcmp(argv[i], "--frames") && has_value) {
+			bench.frames = atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--warmup") && has_value) {
+			bench.warmup = atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--size") && has_value) {
+			sscanf(argv[++i], "%dx%d", &bench.width, &bench.height);
+		} else if(!strcmp(argv[i], "--out") && has_value) {
+			bench.output = argv[++i];
+		} else if(!strcmp(argv[i], "--late-latch")) {
+			late_latch = true;
+		} else if(!strcmp(argv[i], "--metrics")) {
+			// Optional block name, see metrics.hpp
+			const char *name = (has_value && strncmp(argv[i + 1], "--", 2))
+				? argv[++i] : NULL;
+			if(!telemetry_open(name))
+				return 1;
+		} else if(!strcmp(argv[i], "--fixed-function")) {
+			shader_enable(false);
+		} else if(!strcmp(argv[i], "--particles") && has_value) {
+			particle_stress = atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--bodies") && has_value) {
+			spatial_bodies = atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--tilemap")) {
+			scene_show_tilemap(true);
+		} else if(!strcmp(argv[i], "--bounds")) {
+			scene_show_bounds(true);
+		} else if(!strcmp(argv[i], "--hud")) {
+			hud_enable(true);
+		} else if(!strcmp(argv[i], "--dynres")) {
+			// Optional frame time budget, in ms
+			if(has_value && strncmp(argv[i + 1], "--", 2))
+				dynres_set_budget(atof(argv[++i]));
+			dynres_enable(true);
+		} else if(!strcmp(argv[i], "--quality")) {
+			// Optional target frame rate
+			if(has_value && strncmp(argv[i + 1], "--", 2))
+				quality_set_target(atof(argv[++i]));
+			quality_enable(true);
+		} else if(!strcmp(argv[i], "--overdraw")) {
+			overdraw_enable(true);
+		} else if(!strcmp(argv[i], "--latency")) {
+			latency_enable(true);
+		} else if(!strcmp(argv[i], "--record") && has_value) {
+			if(!replay_record(argv[++i]))
+				return 1;
+		} else if(!strcmp(argv[i], "--replay") && has_value) {
+			if(!replay_open(argv[++i]))
+				return 1;
+		} else if(!strcmp(argv[i], "--alloc-strict") && has_value) {
+			i++;
+			alloc_strict = !strcmp(argv[i], "abort") ? MEM_STRICT_ABORT : MEM_STRICT_LOG;
+		} else if(!strcmp(argv[i], "--capture") && has_value) {
+			capture_path = argv[++i];
+		} else if(!strcmp(argv[i], "--capture-frames") && has_value) {
+			capture_frames = atoi(argv[++i]);
+		}
+	}
+
+	if(bench_mode && spatial_bodies > 0)
+		return bench_spatial(spatial_bodies, &bench);
+	if(bench_mode)
+		return run_bench(&bench);
+
 	glutInit(&argc, argv);
-	glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH);
+	glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH | GLUT_STENCIL);
 
 	glutInitWindowPosition(
 		(glutGet(GLUT_SCREEN_WIDTH) - WINW) / 2,
@@ -134,8 +360,14 @@ main(int argc, char **argv)
 	
 	glutCreateWindow("MyGame");
 
+	if(capture_path && !gltrace_begin(capture_path, capture_frames, WINW, WINH))
+		return 1;
+
 	render_init();
+	hud_init();
 	scene_init();
+	scene_set_particle_stress(particle_stress);
+	timer_add(2000.0, 2000.0, update_title, NULL); // Every 2s
 
 	glutDisplayFunc(display);
 	glutKeyboardFunc(keyDown);
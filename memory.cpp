@@ -0,0 +1,263 @@
+#include "memory.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#define vsnprintf _vsnprintf
+#else
+#include <execinfo.h>
+#include <unistd.h>
+#endif
+
+#include "profile.hpp"
+
+#define MEM_HEADER     16 // Keeps the block 16-byte aligned
+#define MEM_BACKTRACE  32
+
+static MemStats  current;
+static MemStats  last_frame;
+static MemStrict strict    = MEM_STRICT_OFF;
+static bool      reporting = false;
+
+static unsigned char arena_block[MEM_ARENA_BYTES + 15];
+static size_t        arena_used = 0;
+
+static unsigned char *
+_arena(void)
+{
+	return (unsigned char*)(((size_t)arena_block + 15) & ~(size_t)15);
+}
+
+static void
+_backtrace(void)
+{
+#ifdef _WIN32
+	void *frames[MEM_BACKTRACE];
+	USHORT count = CaptureStackBackTrace(1, MEM_BACKTRACE, frames, NULL);
+	for(USHORT i = 0; i < count; i++)
+		fprintf(stderr, "  %p\n", frames[i]);
+#else
+	void *frames[MEM_BACKTRACE];
+	int count = backtrace(frames, MEM_BACKTRACE);
+	backtrace_symbols_fd(frames + 1, count - 1, STDERR_FILENO);
+#endif
+}
+
+// Written straight to stderr: this can run inside any allocation,
+// including ones made while the logger is busy.
+static void
+_report(size_t size)
+{
+	if(reporting)
+		return;
+	reporting = true;
+
+	int zone = profile_current();
+	const ProfileZoneStats *zones;
+	profile_last(&zones);
+	fprintf(stderr, "memory: %lu byte allocation in steady state (zone %s)\n",
+	        (unsigned long)size, zone != PROFILE_NONE ? zones[zone].name : "none");
+	_backtrace();
+	fflush(stderr);
+
+	if(strict == MEM_STRICT_ABORT)
+		abort();
+	reporting = false;
+}
+
+static void *
+_alloc(size_t size)
+{
+	unsigned char *block = (unsigned char*)malloc(size + MEM_HEADER);
+	if(!block)
+		return NULL;
+	*(size_t*)block = size;
+
+	current.allocs++;
+	current.bytes_allocated += size;
+	current.bytes_live += size;
+	profile_alloc(size);
+	if(strict != MEM_STRICT_OFF)
+		_report(size);
+
+	return block + MEM_HEADER;
+}
+
+static void
+_free(void *ptr)
+{
+	if(!ptr)
+		return;
+	unsigned char *block = (unsigned char*)ptr - MEM_HEADER;
+	current.frees++;
+	current.bytes_live -= *(size_t*)block;
+	free(block);
+}
+
+// Counts as freeing the old block and allocating the new one
+static void *
+_realloc(void *ptr, size_t size)
+{
+	if(!ptr)
+		return _alloc(size);
+	if(size == 0) {
+		_free(ptr);
+		return NULL;
+	}
+
+	unsigned char *old = (unsigned char*)ptr - MEM_HEADER;
+	size_t old_size = *(size_t*)old;
+	unsigned char *block = (unsigned char*)realloc(old, size + MEM_HEADER);
+	if(!block)
+		return NULL;
+	*(size_t*)block = size;
+
+	current.frees++;
+	current.bytes_live -= old_size;
+	current.allocs++;
+	current.bytes_allocated += size;
+	current.bytes_live += size;
+	profile_alloc(size);
+	if(strict != MEM_STRICT_OFF)
+		_report(size);
+
+	return block + MEM_HEADER;
+}
+
+void *
+operator new(size_t size) throw(std::bad_alloc)
+{
+	void *ptr = _alloc(size ? size : 1);
+	if(!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void *
+operator new[](size_t size) throw(std::bad_alloc)
+{
+	void *ptr = _alloc(size ? size : 1);
+	if(!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void *
+operator new(size_t size, const std::nothrow_t&) throw()
+{
+	return _alloc(size ? size : 1);
+}
+
+void *
+operator new[](size_t size, const std::nothrow_t&) throw()
+{
+	return _alloc(size ? size : 1);
+}
+
+void
+operator delete(void *ptr) throw()
+{
+	_free(ptr);
+}
+
+void
+operator delete[](void *ptr) throw()
+{
+	_free(ptr);
+}
+
+void
+operator delete(void *ptr, const std::nothrow_t&) throw()
+{
+	_free(ptr);
+}
+
+void
+operator delete[](void *ptr, const std::nothrow_t&) throw()
+{
+	_free(ptr);
+}
+
+void *
+mem_alloc(size_t size)
+{
+	return _alloc(size ? size : 1);
+}
+
+void *
+mem_realloc(void *ptr, size_t size)
+{
+	return _realloc(ptr, size);
+}
+
+void
+mem_free(void *ptr)
+{
+	_free(ptr);
+}
+
+void
+mem_set_strict(MemStrict mode)
+{
+#ifndef _WIN32
+	// The first backtrace() loads libgcc, which allocates
+	if(mode != MEM_STRICT_OFF) {
+		void *frame;
+		backtrace(&frame, 1);
+	}
+#endif
+	strict = mode;
+}
+
+void
+mem_frame(void)
+{
+	current.arena_used = arena_used;
+	last_frame = current;
+	current.allocs = current.frees = 0;
+	current.bytes_allocated = 0;
+	current.arena_used = 0;
+	arena_used = 0;
+}
+
+void
+mem_last(MemStats *stats)
+{
+	*stats = last_frame;
+}
+
+void *
+mem_frame_alloc(size_t size)
+{
+	size_t start = (arena_used + 15) & ~(size_t)15;
+	if(start + size > MEM_ARENA_BYTES)
+		return NULL;
+	arena_used = start + size;
+	return _arena() + start;
+}
+
+// Formats into the arena; returns "" when it is full
+char *
+mem_frame_printf(const char *format, ...)
+{
+	static char empty[1] = { '\0' };
+	size_t start = arena_used;
+	size_t room = MEM_ARENA_BYTES - start;
+	if(room == 0)
+		return empty;
+
+	va_list args;
+	va_start(args, format);
+	char *text = (char*)_arena() + start;
+	int length = vsnprintf(text, room, format, args);
+	va_end(args);
+
+	if(length < 0 || (size_t)length >= room)
+		return empty;
+	arena_used = start + length + 1;
+	return text;
+}
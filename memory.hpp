@@ -0,0 +1,49 @@
+#ifndef MEMORY_HPP_INCLUDED
+#define MEMORY_HPP_INCLUDED
+
+#include <cstddef>
+
+// Allocation tracking and per-frame scratch memory.
+//
+// memory.cpp replaces the global operator new/delete, and engine code
+// allocates with mem_alloc/mem_realloc/mem_free instead of malloc:
+// every call is counted for the frame and for the innermost profile
+// zone. In strict mode an allocation is reported with a backtrace, and
+// with MEM_STRICT_ABORT the process aborts. Turn strict mode on once
+// the game reaches steady state. Plain malloc is not tracked, so only
+// use it off the frame loop (the logger thread, tools).
+//
+// The frame arena is a linear allocator reset by mem_frame, for
+// strings and scratch buffers that do not outlive the frame.
+
+#define MEM_ARENA_BYTES (64 * 1024)
+
+enum MemStrict
+{
+	MEM_STRICT_OFF,
+	MEM_STRICT_LOG,
+	MEM_STRICT_ABORT
+};
+
+struct MemStats
+{
+	unsigned int  allocs;
+	unsigned int  frees;
+	unsigned long bytes_allocated;
+	unsigned long bytes_live;  // At the end of the frame
+	unsigned long arena_used;  // Peak arena use in the frame
+};
+
+void  mem_set_strict(MemStrict mode);
+void  mem_frame(void); // Closes the frame and resets the arena
+void  mem_last(MemStats *stats);
+
+// Tracked heap blocks; free them with mem_free only
+void *mem_alloc(size_t size);
+void *mem_realloc(void *ptr, size_t size); // Size 0 frees, returns NULL
+void  mem_free(void *ptr);
+
+void *mem_frame_alloc(size_t size); // 16-byte aligned, NULL when full
+char *mem_frame_printf(const char *format, ...);
+
+#endif // MEMORY_HPP_INCLUDED
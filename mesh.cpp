@@ -0,0 +1,82 @@
+#include "mesh.hpp"
+#include <cstdlib>
+#include <GL/gl.h>
+
+#include "memory.hpp"
+#include "glstats.hpp"
+
+// Coarser levels are only picked once the mesh is that much
+// smaller than the level threshold, to avoid popping.
+static const float hysteresis = 0.15f;
+
+static int frame_triangles = 0;
+static int last_triangles  = 0;
+
+void
+mesh_lod_free(MeshLod *mesh)
+{
+	for(int i = 0; i < mesh->num_levels; i++) {
+		mem_free(mesh->levels[i].vertices);
+		mem_free(mesh->levels[i].indices);
+		mesh->levels[i].vertices = NULL;
+		mesh->levels[i].indices = NULL;
+	}
+	mesh->num_levels = 0;
+	mesh->current = 0;
+}
+
+int
+mesh_lod_select(MeshLod *mesh, float pixel_radius)
+{
+	int level = mesh->current;
+
+	// Refine as soon as the mesh grows past a threshold...
+	while(level > 0 && pixel_radius >= mesh->levels[level - 1].min_pixels)
+		level--;
+
+	// ...but only coarsen once it is clearly below it
+	while(level < mesh->num_levels - 1 &&
+	      pixel_radius < mesh->levels[level].min_pixels * (1.0f - hysteresis))
+		level++;
+
+	if(level < mesh->min_level)
+		level = mesh->min_level;
+
+	mesh->current = level;
+	return level;
+}
+
+void
+mesh_lod_draw(const MeshLod *mesh)
+{
+	const MeshLevel &lvl = mesh->levels[mesh->current];
+	const GLsizei stride = 6 * sizeof(float);
+
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glNormalPointer(GL_FLOAT, stride, lvl.vertices);
+	glVertexPointer(3, GL_FLOAT, stride, lvl.vertices + 3);
+	glDrawElements(GL_TRIANGLES, lvl.num_indices, GL_UNSIGNED_SHORT, lvl.indices);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+
+	frame_triangles += lvl.num_indices / 3;
+}
+
+void
+mesh_begin_frame(void)
+{
+	frame_triangles = 0;
+}
+
+void
+mesh_end_frame(void)
+{
+	last_triangles = frame_triangles;
+}
+
+int
+mesh_triangles_submitted(void)
+{
+	return last_triangles;
+}
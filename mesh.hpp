@@ -0,0 +1,35 @@
+#ifndef MESH_HPP_INCLUDED
+#define MESH_HPP_INCLUDED
+
+// Meshes with a few precomputed levels of detail. Levels go from
+// the most detailed (0) to the coarsest and are picked every frame
+// from the projected radius of the mesh in pixels.
+
+#define MESH_MAX_LEVELS 4
+
+struct MeshLevel
+{
+	float          *vertices; // Interleaved normal + position
+	unsigned short *indices;  // Triangle list
+	int             num_vertices;
+	int             num_indices;
+	float           min_pixels; // Smallest on-screen radius for this level
+};
+
+struct MeshLod
+{
+	MeshLevel levels[MESH_MAX_LEVELS];
+	int       num_levels;
+	int       current;
+	int       min_level; // Most detailed level allowed
+	float     radius; // Bounding sphere radius
+};
+
+void mesh_lod_free(MeshLod *mesh);
+int  mesh_lod_select(MeshLod *mesh, float pixel_radius);
+void mesh_lod_draw(const MeshLod *mesh);
+void mesh_begin_frame(void);
+void mesh_end_frame(void);          // After the last mesh is drawn
+int  mesh_triangles_submitted(void); // Last finished frame
+
+#endif // MESH_HPP_INCLUDED
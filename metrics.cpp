@@ -0,0 +1,156 @@
+#include "metrics.hpp"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "atomic.hpp"
+
+#define METRICS_READ_TRIES 100
+
+static bool
+_is_shm_name(const char *name)
+{
+	return name[0] == '/' && !strchr(name + 1, '/');
+}
+
+#ifdef _WIN32
+static HANDLE mapping = NULL;
+
+MetricsBlock *
+metrics_map(const char *name, bool create)
+{
+	char object[256];
+	_snprintf(object, sizeof(object), "Local\\%s", name + (name[0] == '/'));
+
+	HANDLE file = INVALID_HANDLE_VALUE;
+	if(!_is_shm_name(name)) {
+		file = CreateFileA(name, GENERIC_READ | (create ? GENERIC_WRITE : 0),
+		                   FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+		                   create ? OPEN_ALWAYS : OPEN_EXISTING, 0, NULL);
+		if(file == INVALID_HANDLE_VALUE) {
+			fprintf(stderr, "metrics: cannot open %s\n", name);
+			return NULL;
+		}
+	}
+
+	mapping = create
+		? CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, sizeof(MetricsBlock),
+		                     file == INVALID_HANDLE_VALUE ? object : NULL)
+		: (file == INVALID_HANDLE_VALUE
+		   ? OpenFileMappingA(FILE_MAP_READ, FALSE, object)
+		   : CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL));
+	if(file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	if(!mapping) {
+		fprintf(stderr, "metrics: cannot map %s\n", name);
+		return NULL;
+	}
+
+	void *view = MapViewOfFile(mapping, create ? FILE_MAP_WRITE : FILE_MAP_READ,
+	                           0, 0, sizeof(MetricsBlock));
+	if(!view) {
+		fprintf(stderr, "metrics: cannot map %s\n", name);
+		CloseHandle(mapping);
+		mapping = NULL;
+	}
+	return (MetricsBlock*)view;
+}
+
+void
+metrics_unmap(MetricsBlock *block, const char *name, bool remove)
+{
+	if(block)
+		UnmapViewOfFile(block);
+	if(mapping)
+		CloseHandle(mapping);
+	mapping = NULL;
+	if(remove && !_is_shm_name(name))
+		DeleteFileA(name);
+}
+#else
+MetricsBlock *
+metrics_map(const char *name, bool create)
+{
+	int flags = create ? (O_RDWR | O_CREAT) : O_RDONLY;
+	int fd = _is_shm_name(name)
+		? shm_open(name, flags, 0644)
+		: open(name, flags, 0644);
+	if(fd < 0) {
+		fprintf(stderr, "metrics: cannot open %s\n", name);
+		return NULL;
+	}
+
+	if(create && ftruncate(fd, sizeof(MetricsBlock)) != 0) {
+		fprintf(stderr, "metrics: cannot resize %s\n", name);
+		close(fd);
+		return NULL;
+	}
+
+	struct stat st;
+	if(!create && (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MetricsBlock))) {
+		fprintf(stderr, "metrics: %s is too small\n", name);
+		close(fd);
+		return NULL;
+	}
+
+	void *view = mmap(NULL, sizeof(MetricsBlock),
+	                  create ? PROT_READ | PROT_WRITE : PROT_READ,
+	                  MAP_SHARED, fd, 0);
+	close(fd);
+	if(view == MAP_FAILED) {
+		fprintf(stderr, "metrics: cannot map %s\n", name);
+		return NULL;
+	}
+	return (MetricsBlock*)view;
+}
+
+void
+metrics_unmap(MetricsBlock *block, const char *name, bool remove)
+{
+	if(block)
+		munmap(block, sizeof(MetricsBlock));
+	if(remove) {
+		if(_is_shm_name(name))
+			shm_unlink(name);
+		else unlink(name);
+	}
+}
+#endif
+
+void
+metrics_write_begin(MetricsBlock *block)
+{
+	block->sequence++;
+	atomic_fence();
+}
+
+void
+metrics_write_end(MetricsBlock *block)
+{
+	atomic_fence();
+	block->sequence++;
+}
+
+bool
+metrics_read(const MetricsBlock *block, MetricsBlock *copy)
+{
+	for(int i = 0; i < METRICS_READ_TRIES; i++) {
+		unsigned int before = block->sequence;
+		if(before & 1)
+			continue;
+		atomic_fence();
+		memcpy(copy, (const void*)block, sizeof(MetricsBlock));
+		atomic_fence();
+		if(block->sequence == before)
+			return true;
+	}
+	return false;
+}
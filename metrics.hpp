@@ -0,0 +1,81 @@
+#ifndef METRICS_HPP_INCLUDED
+#define METRICS_HPP_INCLUDED
+
+// Shared-memory metrics block, written once per frame by the game and
+// read by external tools (bin/mgstat). The layout is fixed and only
+// changes together with METRICS_VERSION.
+//
+// The writer bumps `sequence` to an odd value, fills the block and
+// bumps it again; readers copy the block and retry until they saw the
+// same even sequence before and after the copy.
+//
+// A name starting with '/' and holding no other '/' is a POSIX shared
+// memory object (a named file mapping on Windows); anything else is a
+// path to a file that is mapped instead.
+
+#define METRICS_MAGIC        0x4d534d4du // "MMSM"
+#define METRICS_VERSION      1
+#define METRICS_DEFAULT_NAME "/mygame-metrics"
+
+#define METRICS_HISTOGRAM_BINS 64 // 1ms each, the last one open-ended
+#define METRICS_MAX_ZONES      32
+#define METRICS_ZONE_NAME      24
+
+struct MetricsZone
+{
+	char         name[METRICS_ZONE_NAME];
+	float        ms;
+	unsigned int calls;
+	unsigned int allocs;
+	unsigned int alloc_bytes;
+};
+
+struct MetricsBlock
+{
+	// Header, never changes after creation
+	unsigned int magic;
+	unsigned int version;
+	unsigned int size; // sizeof(MetricsBlock)
+	unsigned int pid;
+
+	volatile unsigned int sequence;
+	unsigned int          padding;
+
+	// Frame counters
+	double       time;       // Seconds since start
+	unsigned int frame;
+	float        frame_ms;
+	float        fps;
+	unsigned int histogram[METRICS_HISTOGRAM_BINS]; // Frames since start
+
+	// Last frame's work
+	unsigned int draw_calls; // GLSTATS builds only
+	unsigned int gl_calls;
+	unsigned int visible;
+	unsigned int culled;
+	unsigned int mesh_triangles;
+
+	// Memory
+	unsigned int allocs;
+	unsigned int alloc_bytes;
+	unsigned int heap_bytes;
+	unsigned int arena_bytes;
+
+	// Textures
+	unsigned int textures;
+	unsigned int textures_resident;
+	unsigned int texture_bytes;
+	unsigned int texture_bytes_resident;
+
+	unsigned int num_zones;
+	MetricsZone  zones[METRICS_MAX_ZONES];
+};
+
+MetricsBlock *metrics_map(const char *name, bool create);
+void          metrics_unmap(MetricsBlock *block, const char *name, bool remove);
+
+void metrics_write_begin(MetricsBlock *block);
+void metrics_write_end(MetricsBlock *block);
+bool metrics_read(const MetricsBlock *block, MetricsBlock *copy);
+
+#endif // METRICS_HPP_INCLUDED
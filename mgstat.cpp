@@ -0,0 +1,139 @@
+// Metrics reader. Maps the block published by `MyGame --metrics` read
+// only and prints a line per interval; never signals or blocks the
+// game.
+//
+//   mgstat [name] [--interval ms] [--count N] [--json]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "metrics.hpp"
+
+static void
+_sleep(int ms)
+{
+#ifdef _WIN32
+	Sleep(ms);
+#else
+	struct timespec t;
+	t.tv_sec = ms / 1000;
+	t.tv_nsec = (ms % 1000) * 1000000L;
+	nanosleep(&t, NULL);
+#endif
+}
+
+// Frame time percentile, in whole ms, from histogram deltas
+static int
+_percentile(const unsigned int *now, const unsigned int *before, double percentile)
+{
+	unsigned int total = 0, seen = 0;
+	for(int i = 0; i < METRICS_HISTOGRAM_BINS; i++)
+		total += now[i] - before[i];
+	if(total == 0)
+		return 0;
+
+	unsigned int rank = (unsigned int)(percentile / 100.0 * total);
+	for(int i = 0; i < METRICS_HISTOGRAM_BINS; i++) {
+		seen += now[i] - before[i];
+		if(seen > rank)
+			return i + 1;
+	}
+	return METRICS_HISTOGRAM_BINS;
+}
+
+static void
+_print_text(const MetricsBlock *m, int p50, int p99)
+{
+	printf("frame %u  fps %.1f  %.2f ms  p50 <%d p99 <%d ms  draws %u  tris %u"
+	       "  heap %u KB  allocs %u  tex %u/%u %u KB\n",
+	       m->frame, m->fps, m->frame_ms, p50, p99, m->draw_calls,
+	       m->mesh_triangles, m->heap_bytes / 1024, m->allocs,
+	       m->textures_resident, m->textures, m->texture_bytes / 1024);
+	printf(" ");
+	for(unsigned int i = 0; i < m->num_zones && i < METRICS_MAX_ZONES; i++)
+		printf(" %s %.3f", m->zones[i].name, m->zones[i].ms);
+	printf("\n");
+}
+
+static void
+_print_json(const MetricsBlock *m, int p50, int p99)
+{
+	printf("{\"pid\": %u, \"time\": %.3f, \"frame\": %u, \"fps\": %.2f, "
+	       "\"frame_ms\": %.3f, \"p50_ms\": %d, \"p99_ms\": %d, "
+	       "\"draw_calls\": %u, \"gl_calls\": %u, \"visible\": %u, "
+	       "\"culled\": %u, \"mesh_triangles\": %u, \"allocs\": %u, "
+	       "\"alloc_bytes\": %u, \"heap_bytes\": %u, \"arena_bytes\": %u, "
+	       "\"textures\": %u, \"textures_resident\": %u, "
+	       "\"texture_bytes\": %u, \"texture_bytes_resident\": %u, \"zones\": {",
+	       m->pid, m->time, m->frame, m->fps, m->frame_ms, p50, p99,
+	       m->draw_calls, m->gl_calls, m->visible, m->culled,
+	       m->mesh_triangles, m->allocs, m->alloc_bytes, m->heap_bytes,
+	       m->arena_bytes, m->textures, m->textures_resident,
+	       m->texture_bytes, m->texture_bytes_resident);
+	for(unsigned int i = 0; i < m->num_zones && i < METRICS_MAX_ZONES; i++) {
+		printf("%s\"%s\": { \"ms\": %.4f, \"calls\": %u, \"allocs\": %u }",
+		       i ? ", " : "", m->zones[i].name, m->zones[i].ms,
+		       m->zones[i].calls, m->zones[i].allocs);
+	}
+	printf("}}\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *name = METRICS_DEFAULT_NAME;
+	int interval = 1000, count = 0;
+	bool json = false;
+
+	for(int i = 1; i < argc; i++) {
+		bool has_value = (i + 1 < argc);
+		if(!strcmp(argv[i], "--interval") && has_value)
+			interval = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--count") && has_value)
+			count = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--json"))
+			json = true;
+		else name = argv[i];
+	}
+
+	const MetricsBlock *shared = metrics_map(name, false);
+	if(!shared)
+		return 1;
+	if(shared->magic != METRICS_MAGIC || shared->version != METRICS_VERSION
+	   || shared->size != sizeof(MetricsBlock)) {
+		fprintf(stderr, "mgstat: %s has layout version %u, expected %u\n",
+		        name, shared->version, METRICS_VERSION);
+		return 1;
+	}
+
+	static MetricsBlock now, before;
+	memset(&before, 0, sizeof(before));
+	for(int n = 0; count == 0 || n < count; n++) {
+		if(n > 0)
+			_sleep(interval);
+		if(!metrics_read(shared, &now)) {
+			fprintf(stderr, "mgstat: block busy, skipped\n");
+			continue;
+		}
+		if(n > 0 && now.frame == before.frame)
+			fprintf(stderr, "mgstat: no new frames\n");
+
+		int p50 = _percentile(now.histogram, before.histogram, 50.0);
+		int p99 = _percentile(now.histogram, before.histogram, 99.0);
+		if(json)
+			_print_json(&now, p50, p99);
+		else _print_text(&now, p50, p99);
+		fflush(stdout);
+		before = now;
+	}
+
+	metrics_unmap((MetricsBlock*)shared, name, false);
+	return 0;
+}
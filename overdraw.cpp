@@ -0,0 +1,156 @@
+#include "overdraw.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <GL/gl.h>
+
+#include "memory.hpp"
+#include "gltrace.hpp"
+
+// Not counted by GLSTATS: the overlay is not part of the scene
+
+struct HeatBand
+{
+	int   count; // Lowest fragment count in the band
+	float r, g, b;
+};
+
+static const HeatBand bands[] = {
+	{   1, 0.0f, 0.0f, 0.5f },
+	{   2, 0.0f, 0.0f, 1.0f },
+	{   3, 0.0f, 0.5f, 1.0f },
+	{   4, 0.0f, 1.0f, 1.0f },
+	{   6, 0.0f, 1.0f, 0.5f },
+	{   8, 0.0f, 1.0f, 0.0f },
+	{  12, 0.5f, 1.0f, 0.0f },
+	{  16, 1.0f, 1.0f, 0.0f },
+	{  24, 1.0f, 0.5f, 0.0f },
+	{  32, 1.0f, 0.0f, 0.0f },
+	{  48, 1.0f, 0.0f, 0.5f },
+	{  64, 1.0f, 1.0f, 1.0f },
+};
+
+static const int num_bands = sizeof(bands) / sizeof(HeatBand);
+
+static bool           enabled     = false;
+static bool           active      = false; // This frame
+static OverdrawStats  last_frame;
+static unsigned char *counts      = NULL; // Stencil readback
+static int            counts_size = 0;
+
+void
+overdraw_enable(bool enable)
+{
+	enabled = enable;
+	memset(&last_frame, 0, sizeof(OverdrawStats));
+}
+
+bool
+overdraw_enabled(void)
+{
+	return enabled;
+}
+
+void
+overdraw_begin_frame(void)
+{
+	active = enabled && !gltrace_on;
+	if(!active)
+		return;
+
+	glClearStencil(0);
+	glClear(GL_STENCIL_BUFFER_BIT);
+	glEnable(GL_STENCIL_TEST);
+	glStencilMask(0xff);
+	glStencilFunc(GL_ALWAYS, 0, 0xff);
+	// Depth-rejected fragments still cost fill, so count them too
+	glStencilOp(GL_KEEP, GL_INCR, GL_INCR);
+}
+
+static void
+_read_stats(int width, int height)
+{
+	int size = width * height;
+	if(size > counts_size) {
+		counts = (unsigned char*)mem_realloc(counts, size);
+		counts_size = size;
+	}
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, counts);
+
+	unsigned long total = 0;
+	int max = 0, covered = 0;
+	for(int i = 0; i < size; i++) {
+		int c = counts[i];
+		total += c;
+		if(c > max)
+			max = c;
+		if(c)
+			covered++;
+	}
+
+	last_frame.average = size ? (double)total / size : 0.0;
+	last_frame.average_covered = covered ? (double)total / covered : 0.0;
+	last_frame.max = max;
+	last_frame.pixels = covered;
+}
+
+void
+overdraw_end_frame(void)
+{
+	if(!active)
+		return;
+	active = false;
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	_read_stats(viewport[2], viewport[3]);
+
+	glPushAttrib(GL_ALL_ATTRIB_BITS);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_TEXTURE_2D);
+
+	// Pixels never drawn go black
+	glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+	glStencilFunc(GL_EQUAL, 0, 0xff);
+	glColor3f(0.0f, 0.0f, 0.0f);
+	glRectf(-1.0f, -1.0f, 1.0f, 1.0f);
+
+	// One full-view quad per band; pass where count >= band
+	for(int i = 0; i < num_bands; i++) {
+		const HeatBand &band = bands[i];
+		glStencilFunc(GL_LEQUAL, band.count, 0xff);
+		glColor3f(band.r, band.g, band.b);
+		glRectf(-1.0f, -1.0f, 1.0f, 1.0f);
+	}
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glPopAttrib();
+	glDisable(GL_STENCIL_TEST);
+}
+
+void
+overdraw_last(OverdrawStats *stats)
+{
+	*stats = last_frame;
+}
+
+void
+overdraw_dispose(void)
+{
+	mem_free(counts);
+	counts = NULL;
+	counts_size = 0;
+}
@@ -0,0 +1,26 @@
+#ifndef OVERDRAW_HPP_INCLUDED
+#define OVERDRAW_HPP_INCLUDED
+
+// Overdraw debug mode. While enabled every rasterized fragment bumps
+// the stencil value of its pixel; at the end of the frame the counts
+// are read back for stats and replace the image with a heat map, from
+// blue (drawn once) through green and yellow to red and white (64+).
+// Needs a stencil buffer. The counts saturate at 255. Off while
+// capturing: stencil state and readbacks are not traced.
+
+struct OverdrawStats
+{
+	double average;         // Fragments per pixel over the whole view
+	double average_covered; // Same, over pixels drawn at least once
+	int    max;
+	int    pixels;          // Pixels drawn at least once
+};
+
+void overdraw_enable(bool enabled);
+bool overdraw_enabled(void);
+void overdraw_begin_frame(void); // After the clear, before drawing
+void overdraw_end_frame(void);   // After drawing, before the swap
+void overdraw_last(OverdrawStats *stats);
+void overdraw_dispose(void);
+
+#endif // OVERDRAW_HPP_INCLUDED
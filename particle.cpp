@@ -0,0 +1,407 @@
+#include "particle.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <GL/gl.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define PARTICLE_SSE
+#endif
+
+#include "render.hpp"
+#include "scenegraph.hpp"
+#include "gltrace.hpp"
+#include "memory.hpp"
+#include "glstats.hpp"
+
+// Not in the GL 1.1 header
+#define PARTICLE_POINT_SPRITE      0x8861
+#define PARTICLE_COORD_REPLACE     0x8862
+#define PARTICLE_POINT_SIZE_RANGE  0x846D // Aliased
+
+#define SPRITE_SIZE 32
+
+struct ParticleVertex
+{
+	float         x, y;
+	float         u, v;
+	unsigned char color[4];
+};
+
+static GLuint          sprite_texture = 0;
+static bool            point_sprites  = false;
+static float           max_point_size = 1.0f;
+static ParticleVertex *vertices       = NULL;
+static int             max_vertices   = 0;
+static unsigned int    seed           = 0x9e3779b9;
+
+static ParticleEmitter emitters[PARTICLE_MAX_EMITTERS];
+
+// xorshift32, so runs and replays see the same particles
+static float
+_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+void
+particle_init(void)
+{
+	// Soft round dot, faded out towards the edge
+	unsigned char texels[SPRITE_SIZE * SPRITE_SIZE];
+	for(int y = 0; y < SPRITE_SIZE; y++) {
+		for(int x = 0; x < SPRITE_SIZE; x++) {
+			float dx = (x + 0.5f) / (SPRITE_SIZE * 0.5f) - 1.0f;
+			float dy = (y + 0.5f) / (SPRITE_SIZE * 0.5f) - 1.0f;
+			float falloff = 1.0f - sqrtf(dx * dx + dy * dy);
+			if(falloff < 0.0f)
+				falloff = 0.0f;
+			texels[y * SPRITE_SIZE + x] = (unsigned char)(falloff * falloff * 255.0f);
+		}
+	}
+
+	glGenTextures(1, &sprite_texture);
+	glBindTexture(GL_TEXTURE_2D, sprite_texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, SPRITE_SIZE, SPRITE_SIZE, 0,
+	             GL_ALPHA, GL_UNSIGNED_BYTE, texels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	track_texture(sprite_texture, SPRITE_SIZE * SPRITE_SIZE);
+
+	// Replays have no point sprite state: captures draw quads
+	point_sprites = !gltrace_on
+		&& (render_gl_version() >= 20 || render_has_extension("GL_ARB_point_sprite"));
+	if(point_sprites) {
+		GLfloat range[2] = { 1.0f, 1.0f };
+		glGetFloatv(PARTICLE_POINT_SIZE_RANGE, range);
+		max_point_size = range[1];
+	}
+
+	for(int i = 0; i < PARTICLE_MAX_EMITTERS; i++)
+		emitters[i].pool = NULL;
+}
+
+void
+particle_dispose(void)
+{
+	free_texture(sprite_texture);
+	sprite_texture = 0;
+	mem_free(vertices);
+	vertices = NULL;
+	max_vertices = 0;
+}
+
+bool
+particle_sprites(void)
+{
+	return point_sprites;
+}
+
+void
+particle_pool_init(ParticlePool *pool, int capacity, float size)
+{
+	pool->x        = (float*)mem_alloc(capacity * sizeof(float));
+	pool->y        = (float*)mem_alloc(capacity * sizeof(float));
+	pool->vx       = (float*)mem_alloc(capacity * sizeof(float));
+	pool->vy       = (float*)mem_alloc(capacity * sizeof(float));
+	pool->life     = (float*)mem_alloc(capacity * sizeof(float));
+	pool->inv_life = (float*)mem_alloc(capacity * sizeof(float));
+	pool->alpha    = (float*)mem_alloc(capacity * sizeof(float));
+	pool->color    = (unsigned int*)mem_alloc(capacity * sizeof(unsigned int));
+	pool->count    = 0;
+	pool->capacity = capacity;
+	pool->limit    = capacity;
+	pool->gravity  = 0.0f;
+	pool->drag     = 0.0f;
+	pool->size     = size;
+}
+
+void
+particle_pool_free(ParticlePool *pool)
+{
+	mem_free(pool->x);
+	mem_free(pool->y);
+	mem_free(pool->vx);
+	mem_free(pool->vy);
+	mem_free(pool->life);
+	mem_free(pool->inv_life);
+	mem_free(pool->alpha);
+	mem_free(pool->color);
+	pool->count = pool->capacity = pool->limit = 0;
+
+	for(int i = 0; i < PARTICLE_MAX_EMITTERS; i++) {
+		if(emitters[i].pool == pool)
+			emitters[i].pool = NULL;
+	}
+}
+
+void
+particle_pool_set_limit(ParticlePool *pool, int limit)
+{
+	if(limit < 0)
+		limit = 0;
+	if(limit > pool->capacity)
+		limit = pool->capacity;
+	pool->limit = limit;
+
+	// Order does not matter, so the excess is just the tail
+	if(pool->count > limit)
+		pool->count = limit;
+}
+
+bool
+particle_spawn(ParticlePool *pool, float x, float y, float vx, float vy,
+               float lifetime, unsigned int color)
+{
+	if(pool->count >= pool->limit || lifetime <= 0.0f)
+		return false;
+
+	int i = pool->count++;
+	pool->x[i]        = x;
+	pool->y[i]        = y;
+	pool->vx[i]       = vx;
+	pool->vy[i]       = vy;
+	pool->life[i]     = lifetime;
+	pool->inv_life[i] = (color & 0xff) / (255.0f * lifetime);
+	pool->alpha[i]    = (color & 0xff) / 255.0f;
+	pool->color[i]    = color & 0xffffff00;
+	return true;
+}
+
+void
+particle_burst(ParticlePool *pool, float x, float y, int count,
+               float speed, float lifetime, unsigned int color)
+{
+	for(int i = 0; i < count; i++) {
+		float angle = _random() * 6.2831853f;
+		float s = speed * (0.25f + 0.75f * _random());
+		if(!particle_spawn(pool, x, y, cosf(angle) * s, sinf(angle) * s,
+		                   lifetime * (0.5f + 0.5f * _random()), color))
+			break;
+	}
+}
+
+static void
+_remove(ParticlePool *pool, int i)
+{
+	int last = --pool->count;
+	pool->x[i]        = pool->x[last];
+	pool->y[i]        = pool->y[last];
+	pool->vx[i]       = pool->vx[last];
+	pool->vy[i]       = pool->vy[last];
+	pool->life[i]     = pool->life[last];
+	pool->inv_life[i] = pool->inv_life[last];
+	pool->alpha[i]    = pool->alpha[last];
+	pool->color[i]    = pool->color[last];
+}
+
+void
+particle_update(ParticlePool *pool, float dt)
+{
+	float keep = 1.0f - pool->drag * dt;
+	if(keep < 0.0f)
+		keep = 0.0f;
+	float pull = pool->gravity * dt;
+	bool any_dead = false;
+	int i = 0;
+
+#ifdef PARTICLE_SSE
+	__m128 step  = _mm_set1_ps(dt);
+	__m128 keep4 = _mm_set1_ps(keep);
+	__m128 pull4 = _mm_set1_ps(pull);
+	__m128 zero  = _mm_setzero_ps();
+	int dead = 0;
+	for(; i + 4 <= pool->count; i += 4) {
+		__m128 vx = _mm_mul_ps(_mm_loadu_ps(pool->vx + i), keep4);
+		__m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(pool->vy + i), pull4), keep4);
+		__m128 life = _mm_sub_ps(_mm_loadu_ps(pool->life + i), step);
+
+		_mm_storeu_ps(pool->vx + i, vx);
+		_mm_storeu_ps(pool->vy + i, vy);
+		_mm_storeu_ps(pool->x + i,
+			_mm_add_ps(_mm_loadu_ps(pool->x + i), _mm_mul_ps(vx, step)));
+		_mm_storeu_ps(pool->y + i,
+			_mm_add_ps(_mm_loadu_ps(pool->y + i), _mm_mul_ps(vy, step)));
+		_mm_storeu_ps(pool->life + i, life);
+		_mm_storeu_ps(pool->alpha + i,
+			_mm_mul_ps(_mm_max_ps(life, zero), _mm_loadu_ps(pool->inv_life + i)));
+		dead |= _mm_movemask_ps(_mm_cmple_ps(life, zero));
+	}
+	any_dead = (dead != 0);
+#endif
+
+	for(; i < pool->count; i++) {
+		pool->vx[i] *= keep;
+		pool->vy[i] = (pool->vy[i] + pull) * keep;
+		pool->x[i] += pool->vx[i] * dt;
+		pool->y[i] += pool->vy[i] * dt;
+		pool->life[i] -= dt;
+		pool->alpha[i] = (pool->life[i] > 0.0f ? pool->life[i] : 0.0f) * pool->inv_life[i];
+		if(pool->life[i] <= 0.0f)
+			any_dead = true;
+	}
+
+	if(!any_dead)
+		return;
+	for(i = 0; i < pool->count; ) {
+		if(pool->life[i] <= 0.0f)
+			_remove(pool, i); // The last one moved here, look again
+		else i++;
+	}
+}
+
+static inline void
+_vertex(ParticleVertex *v, float x, float y, float u, float t,
+        unsigned int color, unsigned char alpha)
+{
+	v->x = x;
+	v->y = y;
+	v->u = u;
+	v->v = t;
+	v->color[0] = (color >> 24) & 0xff;
+	v->color[1] = (color >> 16) & 0xff;
+	v->color[2] = (color >> 8) & 0xff;
+	v->color[3] = alpha;
+}
+
+void
+particle_draw(ParticlePool *pool)
+{
+	if(pool->count == 0)
+		return;
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	float point_size = pool->size * viewport[2] * 0.5f;
+	bool sprites = point_sprites && point_size <= max_point_size;
+
+	// Sized for the largest pool drawn, full and as quads, so it does
+	// not grow again as the pool fills up
+	int needed = pool->capacity * 4;
+	if(needed > max_vertices) {
+		mem_free(vertices);
+		vertices = (ParticleVertex*)mem_alloc(needed * sizeof(ParticleVertex));
+		max_vertices = needed;
+	}
+
+	ParticleVertex *v = vertices;
+	float h = pool->size * 0.5f;
+	for(int i = 0; i < pool->count; i++) {
+		unsigned char alpha = (unsigned char)(pool->alpha[i] * 255.0f);
+		float x = pool->x[i], y = pool->y[i];
+		unsigned int color = pool->color[i];
+		if(sprites) {
+			_vertex(v++, x, y, 0.0f, 0.0f, color, alpha);
+			continue;
+		}
+		_vertex(v++, x - h, y - h, 0.0f, 0.0f, color, alpha);
+		_vertex(v++, x + h, y - h, 1.0f, 0.0f, color, alpha);
+		_vertex(v++, x + h, y + h, 1.0f, 1.0f, color, alpha);
+		_vertex(v++, x - h, y + h, 0.0f, 1.0f, color, alpha);
+	}
+
+	glDepthMask(GL_FALSE);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, sprite_texture);
+	glLoadIdentity();
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(ParticleVertex), &vertices[0].x);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(ParticleVertex), vertices[0].color);
+
+	if(sprites) {
+		glEnable(PARTICLE_POINT_SPRITE);
+		glTexEnvi(PARTICLE_POINT_SPRITE, PARTICLE_COORD_REPLACE, GL_TRUE);
+		glPointSize(point_size);
+		glDrawArrays(GL_POINTS, 0, pool->count);
+		glPointSize(1.0f);
+		glDisable(PARTICLE_POINT_SPRITE);
+	} else {
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(ParticleVertex), &vertices[0].u);
+		glDrawArrays(GL_QUADS, 0, pool->count * 4);
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	}
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_TRUE);
+}
+
+int
+particle_emitter_add(ParticlePool *pool, int node, float rate,
+                     float speed, float lifetime, unsigned int color)
+{
+	for(int i = 0; i < PARTICLE_MAX_EMITTERS; i++) {
+		ParticleEmitter &e = emitters[i];
+		if(e.pool != NULL)
+			continue;
+		e.pool     = pool;
+		e.node     = node;
+		e.x        = 0.0f;
+		e.y        = 0.0f;
+		e.rate     = rate;
+		e.angle    = 0.0f;
+		e.spread   = 3.14159265f;
+		e.speed    = speed;
+		e.lifetime = lifetime;
+		e.color    = color;
+		e.pending  = 0.0f;
+		return i;
+	}
+	return -1;
+}
+
+ParticleEmitter *
+particle_emitter(int emitter)
+{
+	if(emitter < 0 || emitter >= PARTICLE_MAX_EMITTERS || emitters[emitter].pool == NULL)
+		return NULL;
+	return &emitters[emitter];
+}
+
+void
+particle_emitter_remove(int emitter)
+{
+	if(particle_emitter(emitter))
+		emitters[emitter].pool = NULL;
+}
+
+void
+particle_emit(float dt)
+{
+	for(int i = 0; i < PARTICLE_MAX_EMITTERS; i++) {
+		ParticleEmitter &e = emitters[i];
+		if(e.pool == NULL)
+			continue;
+
+		float x = e.x, y = e.y;
+		if(e.node != SG_ROOT) {
+			const float *world = sg_world(e.node);
+			x += world[12];
+			y += world[13];
+		}
+
+		e.pending += e.rate * dt;
+		int count = (int)e.pending;
+		e.pending -= count;
+		for(int k = 0; k < count; k++) {
+			float angle = e.angle + e.spread * (2.0f * _random() - 1.0f);
+			float speed = e.speed * (0.5f + 0.5f * _random());
+			if(!particle_spawn(e.pool, x, y, cosf(angle) * speed, sinf(angle) * speed,
+			                   e.lifetime * (0.75f + 0.25f * _random()), e.color))
+				break;
+		}
+	}
+}
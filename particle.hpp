@@ -0,0 +1,67 @@
+#ifndef PARTICLE_HPP_INCLUDED
+#define PARTICLE_HPP_INCLUDED
+
+// Particles kept as structure of arrays in fixed capacity pools, so
+// the update runs over plain float arrays four at a time when SSE is
+// available. Dead particles are swap-removed: the pool stays packed
+// and its order is not meaningful. Emitters spawn into a pool at a
+// steady rate and can follow a scene graph node.
+//
+// Drawn as point sprites where GL 2.0 or ARB_point_sprite allows,
+// otherwise as one batch of textured quads. Positions and sizes are
+// in the same units as the rest of the scene.
+
+#define PARTICLE_MAX_EMITTERS 16
+
+struct ParticlePool
+{
+	float        *x, *y;
+	float        *vx, *vy;
+	float        *life;     // Seconds left
+	float        *inv_life; // Alpha at full life over the lifetime
+	float        *alpha;
+	unsigned int *color;    // 0xRRGGBB00, alpha comes from life
+	int           count;
+	int           capacity;
+	int           limit;   // Live particles allowed, up to capacity
+
+	float         gravity; // Added to vy, per second
+	float         drag;    // Fraction of velocity lost per second
+	float         size;    // Sprite width
+};
+
+struct ParticleEmitter
+{
+	ParticlePool *pool;
+	int           node;     // Followed scene graph node, or SG_ROOT
+	float         x, y;     // Offset from the node
+	float         rate;     // Particles per second
+	float         angle;    // Direction, in radians
+	float         spread;   // Half the cone, in radians
+	float         speed;
+	float         lifetime; // In seconds
+	unsigned int  color;    // 0xRRGGBBAA
+	float         pending;  // Fraction of a particle owed
+};
+
+void particle_init(void); // Needs a GL context
+void particle_dispose(void);
+
+void particle_pool_init(ParticlePool *pool, int capacity, float size);
+void particle_pool_free(ParticlePool *pool);
+void particle_pool_set_limit(ParticlePool *pool, int limit); // Drops the excess
+bool particle_spawn(ParticlePool *pool, float x, float y, float vx, float vy,
+                    float lifetime, unsigned int color);
+void particle_burst(ParticlePool *pool, float x, float y, int count,
+                    float speed, float lifetime, unsigned int color);
+void particle_update(ParticlePool *pool, float dt);
+void particle_draw(ParticlePool *pool);
+bool particle_sprites(void); // Point sprites in use
+
+int  particle_emitter_add(ParticlePool *pool, int node, float rate,
+                          float speed, float lifetime, unsigned int color);
+ParticleEmitter *particle_emitter(int emitter);
+void particle_emitter_remove(int emitter);
+void particle_emit(float dt); // Runs every emitter
+
+#endif // PARTICLE_HPP_INCLUDED
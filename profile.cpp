@@ -0,0 +1,95 @@
+#include "profile.hpp"
+#include <cstring>
+
+#include "fps.hpp"
+
+static ProfileZoneStats current[PROFILE_MAX_ZONES];
+static ProfileZoneStats last_frame[PROFILE_MAX_ZONES];
+static int              num_zones = 0;
+
+static int    stack[PROFILE_MAX_DEPTH];
+static int    depth      = 0;
+static double last_mark  = 0.0; // When the innermost zone last resumed
+
+int
+profile_zone(const char *name)
+{
+	for(int i = 0; i < num_zones; i++) {
+		if(!strcmp(current[i].name, name))
+			return i;
+	}
+	if(num_zones >= PROFILE_MAX_ZONES)
+		return PROFILE_NONE;
+
+	memset(&current[num_zones], 0, sizeof(ProfileZoneStats));
+	current[num_zones].name = name;
+	last_frame[num_zones] = current[num_zones];
+	return num_zones++;
+}
+
+// Charges the time since the last mark to the innermost zone
+static void
+_mark(void)
+{
+	double now = getElapsedTime();
+	int zone = profile_current();
+	if(zone != PROFILE_NONE)
+		current[zone].ms += (now - last_mark) * 1000.0;
+	last_mark = now;
+}
+
+void
+profile_begin(int zone)
+{
+	_mark();
+	if(depth < PROFILE_MAX_DEPTH)
+		stack[depth] = zone;
+	if(zone != PROFILE_NONE)
+		current[zone].calls++;
+	depth++;
+}
+
+void
+profile_end(void)
+{
+	_mark();
+	if(depth > 0)
+		depth--;
+}
+
+int
+profile_current(void)
+{
+	if(depth == 0 || depth > PROFILE_MAX_DEPTH)
+		return PROFILE_NONE;
+	return stack[depth - 1];
+}
+
+void
+profile_alloc(unsigned long bytes)
+{
+	int zone = profile_current();
+	if(zone == PROFILE_NONE)
+		return;
+	current[zone].allocs++;
+	current[zone].bytes += bytes;
+}
+
+void
+profile_frame(void)
+{
+	_mark();
+	for(int i = 0; i < num_zones; i++) {
+		last_frame[i] = current[i];
+		current[i].ms = 0.0;
+		current[i].calls = current[i].allocs = 0;
+		current[i].bytes = 0;
+	}
+}
+
+int
+profile_last(const ProfileZoneStats **zones)
+{
+	*zones = last_frame;
+	return num_zones;
+}
@@ -0,0 +1,41 @@
+#ifndef PROFILE_HPP_INCLUDED
+#define PROFILE_HPP_INCLUDED
+
+// Named CPU zones, timed per frame. Register a zone once and open it
+// with a ProfileScope:
+//
+//   static int zone = profile_zone("scene_update");
+//   ProfileScope scope(zone);
+//
+// Zones nest; time and allocations are charged to the innermost open
+// zone only. Main thread only.
+
+#define PROFILE_MAX_ZONES 32
+#define PROFILE_MAX_DEPTH 16
+#define PROFILE_NONE      -1
+
+struct ProfileZoneStats
+{
+	const char   *name;
+	double        ms;     // Exclusive time
+	unsigned int  calls;
+	unsigned int  allocs; // operator new calls, see memory.hpp
+	unsigned long bytes;
+};
+
+int  profile_zone(const char *name); // Name must be a literal
+void profile_begin(int zone);
+void profile_end(void);
+int  profile_current(void);          // Innermost open zone or PROFILE_NONE
+void profile_alloc(unsigned long bytes);
+void profile_frame(void);            // Closes the current frame
+int  profile_last(const ProfileZoneStats **zones);
+
+class ProfileScope
+{
+public:
+	ProfileScope(int zone) { profile_begin(zone); }
+	~ProfileScope()        { profile_end(); }
+};
+
+#endif // PROFILE_HPP_INCLUDED
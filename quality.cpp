@@ -0,0 +1,227 @@
+#include "quality.hpp"
+#include <cmath>
+#include <cstring>
+
+#include "fps.hpp"
+#include "log.hpp"
+
+// Over the target by less than this fraction is left alone
+#define QUALITY_SLACK     0.05
+// Stepping up needs this much more headroom than the step costs
+#define QUALITY_UP_MARGIN 1.5
+// Learned costs stay above this many ms, so no knob looks free
+#define QUALITY_MIN_COST  0.05
+
+static QualityKnob  knobs[QUALITY_MAX_KNOBS];
+static bool         enabled   = false;
+static double       target_ms = 1000.0 / 60.0;
+static int          frames    = 0;
+static int          under     = 0;     // Windows in a row with headroom
+static bool         at_floor  = false; // Logged that nothing is left to lower
+static int          last_knob = -1;    // Stepped at the end of the last window
+static int          last_step = 0;     // -1 down, 1 up
+static double       last_p90  = 0.0;
+static QualityStats stats;
+
+int
+quality_register(const char *name, int levels, int level, float cost,
+                 QualitySetFunc set, void *data)
+{
+	for(int i = 0; i < QUALITY_MAX_KNOBS; i++) {
+		QualityKnob &knob = knobs[i];
+		if(knob.name)
+			continue;
+		knob.name   = name;
+		knob.level  = level;
+		knob.levels = levels;
+		knob.cost   = cost;
+		knob.set    = set;
+		knob.data   = data;
+		return i;
+	}
+	log_warn("quality: no room for knob %s", name);
+	return -1;
+}
+
+void
+quality_unregister(int knob)
+{
+	if(quality_knob(knob))
+		knobs[knob].name = NULL;
+}
+
+void
+quality_set_cost(int knob, float cost)
+{
+	if(quality_knob(knob))
+		knobs[knob].cost = cost;
+}
+
+const QualityKnob *
+quality_knob(int knob)
+{
+	if(knob < 0 || knob >= QUALITY_MAX_KNOBS || knobs[knob].name == NULL)
+		return NULL;
+	return &knobs[knob];
+}
+
+void
+quality_enable(bool enable)
+{
+	if(enable && !enabled) {
+		frames = under = 0;
+		at_floor = false;
+		last_knob = -1;
+		memset(&stats, 0, sizeof(QualityStats));
+	}
+	enabled = enable;
+}
+
+bool
+quality_enabled(void)
+{
+	return enabled;
+}
+
+void
+quality_set_target(double fps)
+{
+	if(fps > 0.0)
+		target_ms = 1000.0 / fps;
+}
+
+static void
+_step(int knob, int delta)
+{
+	QualityKnob &k = knobs[knob];
+	int from = k.level;
+	k.level += delta;
+	k.set(k.level, k.data);
+	log_info("quality: p90 %.2f ms against %.2f, %s %d -> %d",
+	         stats.p90_ms, target_ms, k.name, from, k.level);
+	last_knob = knob;
+	last_step = delta;
+	last_p90 = stats.p90_ms;
+}
+
+// The cheapest step covering the excess, else the biggest one
+static int
+_pick_down(double excess)
+{
+	int best = -1;
+	for(int i = 0; i < QUALITY_MAX_KNOBS; i++) {
+		const QualityKnob &k = knobs[i];
+		if(k.name == NULL || k.level == 0)
+			continue;
+		if(best < 0) {
+			best = i;
+			continue;
+		}
+
+		float cost = knobs[best].cost;
+		bool covers = k.cost >= excess;
+		if(covers != (cost >= excess)) {
+			if(covers)
+				best = i;
+		} else if(covers ? k.cost < cost : k.cost > cost) {
+			best = i;
+		}
+	}
+	return best;
+}
+
+// The cheapest step that fits in the headroom
+static int
+_pick_up(double headroom)
+{
+	int best = -1;
+	for(int i = 0; i < QUALITY_MAX_KNOBS; i++) {
+		const QualityKnob &k = knobs[i];
+		if(k.name == NULL || k.level >= k.levels - 1)
+			continue;
+		if(k.cost * QUALITY_UP_MARGIN > headroom)
+			continue;
+		if(best < 0 || k.cost < knobs[best].cost)
+			best = i;
+	}
+	return best;
+}
+
+void
+quality_frame(void)
+{
+	if(!enabled || ++frames < QUALITY_WINDOW)
+		return;
+	frames = 0;
+
+	stats.target_ms = target_ms;
+	stats.p90_ms = getRecentFrameTimePercentile(90.0, QUALITY_WINDOW);
+
+	// The window after a step shows what it was worth; estimates
+	// move halfway to what was seen. A change within the slack is
+	// noise, and a step that went the wrong way saved next to nothing.
+	double change = last_p90 - stats.p90_ms;
+	if(quality_knob(last_knob) && fabs(change) > target_ms * QUALITY_SLACK) {
+		QualityKnob &k = knobs[last_knob];
+		double saved = last_step < 0 ? change : -change;
+		if(saved < QUALITY_MIN_COST)
+			saved = QUALITY_MIN_COST;
+		k.cost = (float)(0.5 * (k.cost + saved));
+	}
+	last_knob = -1;
+
+	if(stats.p90_ms > target_ms * (1.0 + QUALITY_SLACK)) {
+		under = 0;
+		int knob = _pick_down(stats.p90_ms - target_ms);
+		if(knob < 0) {
+			if(!at_floor)
+				log_warn("quality: p90 %.2f ms against %.2f with every knob at its lowest",
+				         stats.p90_ms, target_ms);
+			at_floor = true;
+			return;
+		}
+		_step(knob, -1);
+		stats.steps_down++;
+		return;
+	}
+
+	at_floor = false;
+	if(stats.p90_ms >= target_ms) {
+		under = 0;
+		return;
+	}
+	if(++under < QUALITY_UP_WINDOWS)
+		return;
+	under = 0;
+
+	int knob = _pick_up(target_ms - stats.p90_ms);
+	if(knob >= 0) {
+		_step(knob, 1);
+		stats.steps_up++;
+	}
+}
+
+void
+quality_stats(QualityStats *out)
+{
+	*out = stats;
+	out->target_ms = target_ms;
+}
+
+void
+quality_write_json(FILE *out, const char *indent)
+{
+	fprintf(out, "{\n");
+	fprintf(out, "%s  \"target_ms\": %.3f,\n", indent, target_ms);
+	fprintf(out, "%s  \"steps_down\": %u,\n", indent, stats.steps_down);
+	fprintf(out, "%s  \"steps_up\": %u,\n", indent, stats.steps_up);
+	fprintf(out, "%s  \"levels\": {", indent);
+	bool first = true;
+	for(int i = 0; i < QUALITY_MAX_KNOBS; i++) {
+		if(knobs[i].name == NULL)
+			continue;
+		fprintf(out, "%s \"%s\": %d", first ? "" : ",", knobs[i].name, knobs[i].level);
+		first = false;
+	}
+	fprintf(out, " }\n%s}", indent);
+}
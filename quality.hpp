@@ -0,0 +1,58 @@
+#ifndef QUALITY_HPP_INCLUDED
+#define QUALITY_HPP_INCLUDED
+
+#include <cstdio>
+
+// Quality governor. Subsystems register knobs: a number of levels, the
+// one in use, a callback applying a level and an estimate of the frame
+// time one step down saves. Every QUALITY_WINDOW frames the governor
+// takes the 90th percentile frame time of the window and steps at most
+// one knob:
+//
+// - down when it is over the target, picking the cheapest step that
+//   covers the excess, or the biggest one when none does;
+// - up after QUALITY_UP_WINDOWS windows in a row with room for a step
+//   and some margin, cheapest first.
+//
+// The window after a step also refines the cost of the knob with the
+// change it made. Every change is logged. While the governor is off
+// knobs stay where they are.
+
+#define QUALITY_MAX_KNOBS  16
+#define QUALITY_WINDOW     60 // Frames
+#define QUALITY_UP_WINDOWS 3
+
+typedef void (*QualitySetFunc)(int level, void *data);
+
+struct QualityKnob
+{
+	const char     *name;   // String literal, NULL for a free slot
+	int             level;  // 0 is the lowest
+	int             levels;
+	float           cost;   // Frame ms saved per step down
+	QualitySetFunc  set;
+	void           *data;
+};
+
+struct QualityStats
+{
+	double       target_ms;
+	double       p90_ms;     // Last window
+	unsigned int steps_down;
+	unsigned int steps_up;
+};
+
+int  quality_register(const char *name, int levels, int level, float cost,
+                      QualitySetFunc set, void *data);
+void quality_unregister(int knob);
+void quality_set_cost(int knob, float cost);
+const QualityKnob *quality_knob(int knob); // NULL for a free slot
+
+void quality_enable(bool enabled);
+bool quality_enabled(void);
+void quality_set_target(double fps);
+void quality_frame(void); // Once per frame, after the swap
+void quality_stats(QualityStats *stats);
+void quality_write_json(FILE *out, const char *indent);
+
+#endif // QUALITY_HPP_INCLUDED
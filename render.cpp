@@ -1,10 +1,38 @@
+#include "memory.hpp"
 #define STB_IMAGE_IMPLEMENTATION
+#define STBI_MALLOC(size)       mem_alloc(size)
+#define STBI_REALLOC(ptr, size) mem_realloc(ptr, size)
+#define STBI_FREE(ptr)          mem_free(ptr)
 #include "stb_image.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
 #include <GL/glut.h>
 #include <GL/gl.h>
-#include <iostream>
+#ifndef _WIN32
+#include <GL/freeglut_ext.h>
+#endif
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 #include "render.hpp"
+#include "log.hpp"
+#include "headless.hpp"
+#include "shader.hpp"
+#include "layer.hpp"
+
+#define MAX_TEXTURES 64
+
+struct TrackedTexture
+{
+	GLuint        name;
+	unsigned long bytes;
+};
+
+static TrackedTexture textures[MAX_TEXTURES];
+static int            num_textures = 0;
+#include "glstats.hpp"
 
 void
 render_init(void)
@@ -25,6 +53,51 @@ render_init(void)
 	glMaterialfv(GL_FRONT, GL_SPECULAR, mat_specular);
 	glMaterialfv(GL_FRONT, GL_SHININESS, mat_shininess);
 	glLightfv(GL_LIGHT0, GL_POSITION, light_position);
+
+	shader_init();
+	layer_init();
+}
+
+int
+render_gl_version(void)
+{
+	const char *version = (const char*)glGetString(GL_VERSION);
+	int major = 0, minor = 0;
+	if(version)
+		sscanf(version, "%d.%d", &major, &minor);
+	return major * 10 + minor;
+}
+
+bool
+render_has_extension(const char *name)
+{
+	const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
+	if(!extensions)
+		return false;
+
+	size_t length = strlen(name);
+	const char *found = extensions;
+	while((found = strstr(found, name)) != NULL) {
+		bool starts = (found == extensions || found[-1] == ' ');
+		bool ends   = (found[length] == ' ' || found[length] == '\0');
+		if(starts && ends)
+			return true;
+		found += length;
+	}
+	return false;
+}
+
+void *
+render_proc_address(const char *name)
+{
+	void *proc = headless_proc_address(name);
+	if(proc)
+		return proc;
+#ifdef _WIN32
+	return (void*)wglGetProcAddress(name);
+#else
+	return (void*)glutGetProcAddress(name);
+#endif
 }
 
 unsigned int
@@ -33,7 +106,7 @@ load_texture(const char *path)
 	int width, height, channels;
 	unsigned char *data = stbi_load(path, &width, &height, &channels, 0);
 	if(data == NULL) {
-		std::cerr << "Error loading texture" << std::endl;
+		log_error("Error loading texture %s: %s", path, stbi_failure_reason());
 		exit(1);
 	}
 	
@@ -54,6 +127,69 @@ load_texture(const char *path)
 	glBindTexture(GL_TEXTURE_2D, 0);
 	glDisable(GL_TEXTURE_2D);
 	stbi_image_free(data);
-	
+
+	track_texture(texture, (unsigned long)width * height * 3);
 	return texture;
+}
+
+void
+set_texture_filter(unsigned int texture, TextureFilter filter)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+	                filter == TEXTURE_LINEAR ? GL_LINEAR : GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+	                filter == TEXTURE_NEAREST ? GL_NEAREST : GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void
+free_texture(unsigned int texture)
+{
+	for(int i = 0; i < num_textures; i++) {
+		if(textures[i].name == texture) {
+			textures[i] = textures[--num_textures];
+			break;
+		}
+	}
+	glDeleteTextures(1, &texture);
+}
+
+void
+track_texture(unsigned int texture, unsigned long bytes)
+{
+	if(num_textures >= MAX_TEXTURES)
+		return;
+	textures[num_textures].name = texture;
+	textures[num_textures].bytes = bytes;
+	num_textures++;
+}
+
+void
+texture_residency(TextureResidency *residency)
+{
+	GLuint names[MAX_TEXTURES];
+	GLboolean resident[MAX_TEXTURES];
+
+	memset(residency, 0, sizeof(TextureResidency));
+	for(int i = 0; i < num_textures; i++) {
+		names[i] = textures[i].name;
+		residency->bytes += textures[i].bytes;
+	}
+	residency->count = num_textures;
+	if(num_textures == 0)
+		return;
+
+	// GL only fills the flags when some texture is not resident
+	if(glAreTexturesResident(num_textures, names, resident)) {
+		residency->resident = num_textures;
+		residency->resident_bytes = residency->bytes;
+		return;
+	}
+	for(int i = 0; i < num_textures; i++) {
+		if(resident[i]) {
+			residency->resident++;
+			residency->resident_bytes += textures[i].bytes;
+		}
+	}
 }
\ No newline at end of file
@@ -1,7 +1,32 @@
 #ifndef RENDER_HPP_INCLUDED
 #define RENDER_HPP_INCLUDED
 
+struct TextureResidency
+{
+	unsigned int  count;
+	unsigned int  resident;
+	unsigned long bytes;
+	unsigned long resident_bytes;
+};
+
 void         render_init(void);
+int          render_gl_version(void); // Major * 10 + minor
+bool         render_has_extension(const char *name);
+void        *render_proc_address(const char *name); // Windowed or headless
 unsigned int load_texture(const char *path);
+void         free_texture(unsigned int texture);
+
+enum TextureFilter
+{
+	TEXTURE_NEAREST,        // Both ways
+	TEXTURE_LINEAR_MAGNIFY, // What load_texture sets
+	TEXTURE_LINEAR
+};
+
+void set_texture_filter(unsigned int texture, TextureFilter filter);
+
+// Textures created elsewhere are tracked with their size in bytes
+void track_texture(unsigned int texture, unsigned long bytes);
+void texture_residency(TextureResidency *residency);
 
 #endif // RENDER_HPP_INCLUDED
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "replay.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "keyboard.hpp"
+#include "fps.hpp"
+
+#define REPLAY_MAGIC   "MGIN"
+#define REPLAY_VERSION 3  // 2 had no tick rate
+#define REPLAY_RATE    60 // Ticks per second of new recordings
+
+enum ReplayMode
+{
+	REPLAY_NONE,
+	REPLAY_RECORDING,
+	REPLAY_PLAYING
+};
+
+static ReplayMode   mode         = REPLAY_NONE;
+static FILE        *stream       = NULL;
+static unsigned int tick         = 0;
+static unsigned int last_tick    = 0;
+static unsigned int last_buttons = 0;
+
+// Next record while replaying
+static bool         has_next     = false;
+static unsigned int next_tick    = 0;
+static unsigned int next_buttons = 0;
+static unsigned int next_taps    = 0;
+
+static void
+_write_varint(unsigned int value)
+{
+	while(value >= 0x80) {
+		fputc((int)((value & 0x7f) | 0x80), stream);
+		value >>= 7;
+	}
+	fputc((int)value, stream);
+}
+
+static bool
+_read_varint(unsigned int *value)
+{
+	unsigned int result = 0;
+	for(int shift = 0; shift < 35; shift += 7) {
+		int c = fgetc(stream);
+		if(c == EOF)
+			return false;
+		result |= (unsigned int)(c & 0x7f) << shift;
+		if(!(c & 0x80)) {
+			*value = result;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void
+_read_next(void)
+{
+	unsigned int delta;
+	has_next = _read_varint(&delta) && _read_varint(&next_buttons)
+		&& _read_varint(&next_taps);
+	if(has_next)
+		next_tick += delta;
+}
+
+static void
+_at_exit(void)
+{
+	replay_close();
+}
+
+bool
+replay_record(const char *path)
+{
+	replay_close();
+	stream = fopen(path, "wb");
+	if(!stream) {
+		fprintf(stderr, "replay: cannot create %s\n", path);
+		return false;
+	}
+
+	fwrite(REPLAY_MAGIC, 1, 4, stream);
+	fputc(REPLAY_VERSION, stream);
+	_write_varint(REPLAY_RATE);
+	fpsSetFixedStep(1.0 / REPLAY_RATE);
+
+	mode = REPLAY_RECORDING;
+	tick = last_tick = last_buttons = 0;
+
+	// GLUT never returns from its main loop, so flush on exit
+	static bool registered = false;
+	if(!registered) {
+		atexit(_at_exit);
+		registered = true;
+	}
+	return true;
+}
+
+bool
+replay_open(const char *path)
+{
+	char magic[4];
+	unsigned int rate;
+
+	replay_close();
+	stream = fopen(path, "rb");
+	if(!stream) {
+		fprintf(stderr, "replay: cannot open %s\n", path);
+		return false;
+	}
+
+	if(fread(magic, 1, 4, stream) != 4 || memcmp(magic, REPLAY_MAGIC, 4)
+	   || fgetc(stream) != REPLAY_VERSION || !_read_varint(&rate) || rate == 0) {
+		fprintf(stderr, "replay: %s is not an input recording\n", path);
+		fclose(stream);
+		stream = NULL;
+		return false;
+	}
+	fpsSetFixedStep(1.0 / rate);
+
+	mode = REPLAY_PLAYING;
+	tick = last_buttons = next_tick = 0;
+	_read_next();
+	return true;
+}
+
+bool
+replay_active(void)
+{
+	return mode == REPLAY_PLAYING;
+}
+
+void
+replay_feed(void)
+{
+	if(mode != REPLAY_PLAYING)
+		return;
+
+	while(has_next && next_tick <= tick) {
+		unsigned int changed = next_buttons ^ last_buttons;
+		for(unsigned int b = 0; b < BTN_COUNT; b++) {
+			unsigned int bit = 1u << b;
+			if(changed & bit) {
+				kbdUpdateButton(b, (next_buttons & bit) != 0);
+			} else if(next_taps & bit) {
+				kbdUpdateButton(b, true);
+				kbdUpdateButton(b, false);
+			}
+		}
+		last_buttons = next_buttons;
+		_read_next();
+	}
+}
+
+void
+replay_tick(void)
+{
+	if(mode == REPLAY_RECORDING) {
+		unsigned int buttons = kbdGetButtons();
+		unsigned int taps = kbdGetPressed() & ~buttons;
+		if(buttons != last_buttons || taps) {
+			_write_varint(tick - last_tick);
+			_write_varint(buttons);
+			_write_varint(taps);
+			last_tick = tick;
+			last_buttons = buttons;
+		}
+	}
+
+	tick++;
+}
+
+void
+replay_close(void)
+{
+	if(stream)
+		fclose(stream);
+	if(mode != REPLAY_NONE)
+		fpsSetFixedStep(0.0);
+	stream = NULL;
+	mode = REPLAY_NONE;
+	has_next = false;
+}
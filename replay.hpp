@@ -0,0 +1,22 @@
+#ifndef REPLAY_HPP_INCLUDED
+#define REPLAY_HPP_INCLUDED
+
+// Input recording and replay. Latched button state is sampled once
+// per simulation tick and only changes are stored, each as a varint
+// tick delta followed by varint held and tapped button masks
+// (1 << BTN_*). Taps are buttons that went down and up within a tick.
+// While replaying, the stream drives the keyboard module in place
+// of the GLUT callbacks.
+//
+// The header holds the simulation rate in ticks per second. Recording
+// and replaying both force that fixed step, windowed or in --bench
+// mode, so a replay sees the same dt on every tick as the recording.
+
+bool replay_record(const char *path);
+bool replay_open(const char *path);
+bool replay_active(void);
+void replay_feed(void); // Before kbdLatch: queue this tick's input
+void replay_tick(void); // After kbdLatch: record this tick
+void replay_close(void);
+
+#endif // REPLAY_HPP_INCLUDED
@@ -6,33 +6,382 @@
 #include "utils.hpp"
 #include "render.hpp"
 #include "keyboard.hpp"
+#include "spatial.hpp"
+#include "scenegraph.hpp"
+#include "cull.hpp"
+#include "lod.hpp"
+#include "mesh.hpp"
+#include "teapot.hpp"
+#include "glstats.hpp"
+#include "timer.hpp"
+#include "shader.hpp"
+#include "shape.hpp"
+#include "particle.hpp"
+#include "profile.hpp"
+#include "tilemap.hpp"
+#include "layer.hpp"
+#include "quality.hpp"
 
 // Rectangle with constant speed
 static GLuint container_texture = 0;
-static float x = 0.0f;
+static float x = -0.5f;
 static float y = 0.0f;
+static const float rect_half = 0.5f;
+static float rect_step = 0.0f; // Distance walked on the last tick
 
 // Ball with accelerated movement
-static float bx  = 0.0f;
+static const float ball_radius = 0.5f;
+static const float ball_bounce = 0.5f;
+static float bx  = 0.5f;
 static float by  = 0.0f;
 static float bsx = 0.0f;
 static float bsy = 0.0f;
+static CircleLod ball_lod;
+static int ball_color_stride = 0;
+static int ball_color_timer = TIMER_NONE;
+
+// Shader path for the ball: one quad, the fan is rebuilt per fragment.
+// Vertex i of the fan sits at angle i * step with rim color
+// (first_color + i) mod 6; fragments take the barycentric mix of the
+// center and the two rim vertices of their slice, like the fan does.
+static const char *ball_vertex_source =
+	"#version 110\n"
+	"varying vec2 local;\n"
+	"void main() {\n"
+	"	local = gl_MultiTexCoord0.xy;\n"
+	"	gl_Position = ftransform();\n"
+	"}\n";
+
+static const char *ball_fragment_source =
+	"#version 110\n"
+	"uniform vec3 palette[6];\n"
+	"uniform float first_color;\n"
+	"uniform float segments;\n"
+	"varying vec2 local;\n"
+	"void main() {\n"
+	"	if(dot(local, local) > 1.0)\n"
+	"		discard;\n"
+	"	float step = 6.2831853 / segments;\n"
+	"	float angle = atan(local.y, local.x);\n"
+	"	if(angle < 0.0)\n"
+	"		angle += 6.2831853;\n"
+	"	float slice = min(floor(angle / step), segments - 1.0);\n"
+	"	vec2 v0 = vec2(cos(slice * step), sin(slice * step));\n"
+	"	vec2 v1 = vec2(cos(slice * step + step), sin(slice * step + step));\n"
+	"	float det = v0.x * v1.y - v0.y * v1.x;\n"
+	"	float w0 = (local.x * v1.y - local.y * v1.x) / det;\n"
+	"	float w1 = (v0.x * local.y - v0.y * local.x) / det;\n"
+	"	float rim = w0 + w1;\n"
+	"	if(rim > 1.0) {\n" // Between the chord and the arc
+	"		w0 /= rim;\n"
+	"		w1 /= rim;\n"
+	"	}\n"
+	"	float c0 = mod(first_color + slice, 6.0);\n"
+	"	float c1 = mod(c0 + 1.0, 6.0);\n"
+	"	vec4 color = vec4(1.0 - w0 - w1);\n"
+	"	color += w0 * vec4(palette[int(c0)], 0.02);\n"
+	"	color += w1 * vec4(palette[int(c1)], 0.02);\n"
+	"	gl_FragColor = color;\n"
+	"}\n";
+
+static unsigned int ball_program = 0;
+static int ball_palette_uniform;
+static int ball_first_color_uniform;
+static int ball_segments_uniform;
 
 // Teapot with constant speed in Z axis
 static float teapot_angle = 0.0f;
 static float teapot_z = 0.0f;
+static MeshLod teapot_mesh;
+
+// Collision bodies, rebuilt from positions every tick
+#define BODY_RECTANGLE 0
+#define BODY_BALL      1
+#define NUM_BODIES     2
+static SpatialBox bodies[NUM_BODIES];
+
+// Scene graph nodes
+static int rect_node   = SG_ROOT;
+static int ball_node   = SG_ROOT;
+static int teapot_node = SG_ROOT;
+
+// Bounding spheres of everything drawn, culled before submission
+#define DRAW_RECTANGLE 0
+#define DRAW_BALL      1
+#define DRAW_TEAPOT    2
+#define NUM_DRAWABLES  3
+static float bound_x[NUM_DRAWABLES];
+static float bound_y[NUM_DRAWABLES];
+static float bound_z[NUM_DRAWABLES];
+static float bound_r[NUM_DRAWABLES];
+static unsigned char visible[NUM_DRAWABLES];
+
+// Sparks trailing the ball and bursting off the rectangle
+#define SPARKS_CAPACITY 4096
+static ParticlePool sparks;
+static int          trail_emitter = -1;
+
+// Filler for the particle benchmark, kept at a steady count
+static ParticlePool stress;
+static int          stress_emitter = -1;
+
+// Backdrop under the scene, cut from the container texture. It pans
+// at half the rectangle's movement and the ball marks the tiles it
+// rolls over; otherwise it is static and drawn from a layer cache.
+#define BACKDROP_TILES    256
+#define BACKDROP_PARALLAX 0.5f
+static Tilemap    backdrop;
+static LayerCache backdrop_layer;
+static float      backdrop_scroll_x = 0.0f, backdrop_scroll_y = 0.0f;
+static int        backdrop_mark_x = -1, backdrop_mark_y = -1;
+static bool       show_backdrop = false;
+static void       _draw_backdrop(void *data);
+
+// Quality knobs, see quality.hpp. Costs are frame ms saved by one
+// step down, measured with bench on llvmpipe at 500x500
+#define KNOB_BALL       0
+#define KNOB_TEAPOT     1
+#define KNOB_PARTICLES  2
+#define KNOB_FILTERING  3
+#define KNOB_LIGHTING   4
+#define NUM_KNOBS       5
+#define PARTICLE_COST   0.4f // Frame ms per thousand live particles
+static int         knobs[NUM_KNOBS];
+static const float ball_errors[] = { 4.0f, 2.0f, 1.0f, 0.5f }; // Pixels
+static const float particle_shares[] = { 0.125f, 0.25f, 0.5f, 1.0f };
+static int         particle_level = 3;
+static int         lighting_level = 2; // Unlit, diffuse, specular
+
+// Debug overlay of the volumes above
+#define BOUNDS_VERTICES 8192
+static ShapeBatch bounds_batch;
+static bool       show_bounds = false;
+
+static void
+_cycle_ball_colors(void *data)
+{
+	ball_color_stride = (ball_color_stride + 3) % (6 * 3);
+}
+
+static void
+_set_ball_tessellation(int level, void *data)
+{
+	lod_set_max_error(ball_errors[level]);
+}
+
+static void
+_set_teapot_lod(int level, void *data)
+{
+	teapot_mesh.min_level = teapot_mesh.num_levels - 1 - level;
+}
+
+static void
+_apply_particle_share(void)
+{
+	float share = particle_shares[particle_level];
+	particle_pool_set_limit(&sparks, (int)(sparks.capacity * share));
+	particle_pool_set_limit(&stress, (int)(stress.capacity * share));
+}
+
+// Stepping down halves what is live; the governor refines it later
+static void
+_estimate_particle_cost(void)
+{
+	quality_set_cost(knobs[KNOB_PARTICLES],
+	                 scene_particles_live() * 0.5f * PARTICLE_COST / 1000.0f);
+}
+
+static void
+_set_particles(int level, void *data)
+{
+	particle_level = level;
+	_apply_particle_share();
+}
+
+static void
+_set_filtering(int level, void *data)
+{
+	set_texture_filter(container_texture, (TextureFilter)level);
+	layer_cache_invalidate(&backdrop_layer);
+}
+
+static void
+_set_lighting(int level, void *data)
+{
+	const GLfloat white[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	const GLfloat black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	lighting_level = level;
+	glMaterialfv(GL_FRONT, GL_SPECULAR, level >= 2 ? white : black);
+}
 
 void
 scene_init(void)
 {
 	container_texture = load_texture("img/win98.png");
+	spatial_init(1.0f, NUM_BODIES);
+
+	sg_reset();
+	rect_node   = sg_create(SG_ROOT);
+	ball_node   = sg_create(SG_ROOT);
+	teapot_node = sg_create(SG_ROOT);
+
+	lod_init();
+	ball_lod.level = 0;
+	teapot_build(&teapot_mesh, 0.3f);
+
+	ball_color_timer = timer_add(50.0, 50.0, _cycle_ball_colors, NULL);
+
+	shape_batch_init(&bounds_batch, BOUNDS_VERTICES);
+
+	tilemap_init(&backdrop, BACKDROP_TILES, BACKDROP_TILES, 0.125f,
+	             container_texture, 4, 4);
+	backdrop.x = -BACKDROP_TILES * backdrop.tile_size * 0.5f;
+	backdrop.y = BACKDROP_TILES * backdrop.tile_size * 0.5f;
+	for(int ty = 0; ty < BACKDROP_TILES; ty++) {
+		for(int tx = 0; tx < BACKDROP_TILES; tx++) {
+			int cell = (tx * 7 + ty * 13 + (tx ^ ty)) % 20;
+			tilemap_set(&backdrop, tx, ty, cell < 16 ? cell + 1 : TILEMAP_EMPTY);
+		}
+	}
+	layer_cache_init(&backdrop_layer, LAYER_OPAQUE, _draw_backdrop, NULL);
+
+	particle_init();
+	particle_pool_init(&sparks, SPARKS_CAPACITY, 0.03f);
+	sparks.gravity = -1.5f;
+	sparks.drag = 0.5f;
+	trail_emitter = particle_emitter_add(&sparks, ball_node, 240.0f, 0.25f, 0.8f, 0xffc040c0);
+	particle_pool_init(&stress, 0, 0.01f);
+
+	ball_program = shader_program(ball_vertex_source, ball_fragment_source);
+	if(ball_program) {
+		ball_palette_uniform     = shader_uniform(ball_program, "palette");
+		ball_first_color_uniform = shader_uniform(ball_program, "first_color");
+		ball_segments_uniform    = shader_uniform(ball_program, "segments");
+	}
+
+	particle_level = 3;
+	lighting_level = 2;
+	knobs[KNOB_BALL] = quality_register("ball_tessellation", 4, 3, 0.05f,
+	                                    _set_ball_tessellation, NULL);
+	knobs[KNOB_TEAPOT] = quality_register("teapot_lod", teapot_mesh.num_levels,
+	                                      teapot_mesh.num_levels - 1, 1.0f,
+	                                      _set_teapot_lod, NULL);
+	knobs[KNOB_PARTICLES] = quality_register("particles", 4, particle_level, 0.0f,
+	                                         _set_particles, NULL);
+	knobs[KNOB_FILTERING] = quality_register("texture_filter", 3, TEXTURE_LINEAR_MAGNIFY,
+	                                         0.2f, _set_filtering, NULL);
+	knobs[KNOB_LIGHTING] = quality_register("lighting", 3, lighting_level, 0.1f,
+	                                        _set_lighting, NULL);
+	_estimate_particle_cost();
 }
 
 void
 scene_dispose(void)
 {
-	glDeleteTextures(1, &container_texture);
+	free_texture(container_texture);
 	container_texture = 0;
+	spatial_dispose();
+	mesh_lod_free(&teapot_mesh);
+	timer_cancel(ball_color_timer);
+	ball_color_timer = TIMER_NONE;
+	shader_free(ball_program);
+	ball_program = 0;
+	shape_batch_free(&bounds_batch);
+	tilemap_free(&backdrop);
+	layer_cache_free(&backdrop_layer);
+	particle_emitter_remove(trail_emitter);
+	particle_emitter_remove(stress_emitter);
+	particle_pool_free(&sparks);
+	particle_pool_free(&stress);
+	particle_dispose();
+	for(int i = 0; i < NUM_KNOBS; i++)
+		quality_unregister(knobs[i]);
+}
+
+void
+scene_set_particle_stress(int count)
+{
+	particle_emitter_remove(stress_emitter);
+	particle_pool_free(&stress);
+	particle_pool_init(&stress, count, 0.01f);
+	stress.gravity = -0.2f;
+	stress_emitter = -1;
+	if(count <= 0) {
+		_apply_particle_share();
+		_estimate_particle_cost();
+		return;
+	}
+
+	// Start full, then emit about as fast as particles expire
+	const float lifetime = 2.0f;
+	particle_burst(&stress, 0.0f, 0.0f, count, 0.8f, lifetime, 0x60a0ffff);
+	stress_emitter = particle_emitter_add(&stress, SG_ROOT, count / (lifetime * 0.8f),
+	                                      0.8f, lifetime, 0x60a0ffff);
+	_apply_particle_share();
+	_estimate_particle_cost();
+}
+
+int
+scene_particles_live(void)
+{
+	return sparks.count + stress.count;
+}
+
+static void
+_collide_ball_rectangle(void)
+{
+	// Closest point of the rectangle to the ball center
+	float cx = clamp(bx, x - rect_half, x + rect_half);
+	float cy = clamp(by, y - rect_half, y + rect_half);
+	float dx = bx - cx;
+	float dy = by - cy;
+	float dist2 = dx * dx + dy * dy;
+
+	if(dist2 >= ball_radius * ball_radius)
+		return;
+
+	float nx, ny, depth;
+	if(dist2 > 0.0f) {
+		float dist = sqrtf(dist2);
+		nx = dx / dist;
+		ny = dy / dist;
+		depth = ball_radius - dist;
+	} else {
+		// Center is inside the rectangle, leave through the nearest side
+		float px = rect_half - fabs(bx - x);
+		float py = rect_half - fabs(by - y);
+		nx = ny = 0.0f;
+		if(px < py) {
+			nx = (bx < x) ? -1.0f : 1.0f;
+			depth = px + ball_radius;
+		} else {
+			ny = (by < y) ? -1.0f : 1.0f;
+			depth = py + ball_radius;
+		}
+	}
+
+	// The rectangle is kinematic, so only the ball is pushed
+	bx += nx * depth;
+	by += ny * depth;
+
+	float vn = bsx * nx + bsy * ny;
+	if(vn < 0.0f) {
+		bsx -= (1.0f + ball_bounce) * vn * nx;
+		bsy -= (1.0f + ball_bounce) * vn * ny;
+
+		// Sparks at the contact point, more for harder hits
+		int count = (int)(-vn * 400.0f);
+		if(count > 8)
+			particle_burst(&sparks, cx, cy, count < 512 ? count : 512,
+			               -vn, 0.6f, 0xffffffff);
+	}
+}
+
+static void
+_collide(int a, int b, void *data)
+{
+	if(a == BODY_RECTANGLE && b == BODY_BALL)
+		_collide_ball_rectangle();
 }
 
 void
@@ -53,6 +402,7 @@ scene_update(double dt)
 	// dt between frames -- s = vt
 
 	float walkdist = pixelspeed * dt;
+	rect_step = walkdist;
 
 	if(kbdPressing(BTN_UP))
 		y += walkdist;
@@ -106,6 +456,20 @@ scene_update(double dt)
 	bx += bsx * dt;
 	by += bsy * dt;
 
+	/* COLLISIONS */
+	bodies[BODY_RECTANGLE].minx = x - rect_half;
+	bodies[BODY_RECTANGLE].maxx = x + rect_half;
+	bodies[BODY_RECTANGLE].miny = y - rect_half;
+	bodies[BODY_RECTANGLE].maxy = y + rect_half;
+
+	bodies[BODY_BALL].minx = bx - ball_radius;
+	bodies[BODY_BALL].maxx = bx + ball_radius;
+	bodies[BODY_BALL].miny = by - ball_radius;
+	bodies[BODY_BALL].maxy = by + ball_radius;
+
+	spatial_build(bodies, NUM_BODIES);
+	spatial_pairs(_collide, NULL);
+
 	// Set light 0 position to ball
 	float lightPos[] = {bx, by, -1.0f, 0.0f};
 	glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
@@ -118,6 +482,57 @@ scene_update(double dt)
 		teapot_z += walkdist;
 	if(kbdPressing(BTN_ACTION1))
 		teapot_z -= walkdist;
+
+	/* Scene graph */
+	sg_set_translation(rect_node, x, y, 0.0f);
+	sg_set_translation(ball_node, bx, by, 0.25f);
+	sg_set_translation(teapot_node, 0.0f, 0.0f, teapot_z);
+	sg_set_rotation(teapot_node, teapot_angle, 0.0f, 1.0f, 0.0f);
+
+	/* Backdrop */
+	if(show_backdrop) {
+		backdrop_scroll_x = x * BACKDROP_PARALLAX;
+		backdrop_scroll_y = y * BACKDROP_PARALLAX;
+		layer_cache_set_view(&backdrop_layer, backdrop_scroll_x, backdrop_scroll_y);
+
+		int tx = (int)floorf((bx + backdrop_scroll_x - backdrop.x) / backdrop.tile_size);
+		int ty = (int)floorf((backdrop.y - by - backdrop_scroll_y) / backdrop.tile_size);
+		if(tx != backdrop_mark_x || ty != backdrop_mark_y) {
+			if(tilemap_get(&backdrop, tx, ty) != 6) {
+				tilemap_set(&backdrop, tx, ty, 6);
+				layer_cache_invalidate(&backdrop_layer);
+			}
+			backdrop_mark_x = tx;
+			backdrop_mark_y = ty;
+		}
+	}
+
+	/* Particles */
+	static int particle_zone = profile_zone("particles");
+	ProfileScope scope(particle_zone);
+	particle_emit((float)dt);
+	particle_update(&sparks, (float)dt);
+	particle_update(&stress, (float)dt);
+}
+
+static void
+_draw_backdrop(void *data)
+{
+	// The view moves over the map, so the map moves the other way
+	float view[16] = {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		-backdrop_scroll_x, -backdrop_scroll_y, 0.0f, 1.0f,
+	};
+
+	glDisable(GL_DEPTH_TEST);
+	glLoadMatrixf(view);
+	glColor4f(1.0f, 1.0f, 1.0f, 0.3f);
+	tilemap_draw(&backdrop, -1.0f + backdrop_scroll_x, -1.0f + backdrop_scroll_y,
+	             1.0f + backdrop_scroll_x, 1.0f + backdrop_scroll_y);
+	glLoadIdentity();
+	glEnable(GL_DEPTH_TEST);
 }
 
 void
@@ -126,9 +541,8 @@ _draw_rectangle(void)
 	// Rectangle
 	glEnable(GL_TEXTURE_2D);
 	glBindTexture(GL_TEXTURE_2D, container_texture);
-	glPushMatrix();
+	sg_load(rect_node);
 		glColor4f(1.0f, 1.0f, 1.0f, 0.2f);
-		glTranslatef(x, y, 0.0f);
 		glBegin(GL_QUADS);
 			glTexCoord2f(0.0f, 0.0f);
 			//glColor4f(1.0f, 0.0f, 0.0f, 1.0f);
@@ -146,7 +560,7 @@ _draw_rectangle(void)
 			//glColor4f(0.0f, 0.0f, 1.0f, 1.0f);
 			glVertex2f(-0.5f, -0.5f);
 		glEnd();
-	glPopMatrix();
+	glLoadIdentity();
 	glDisable(GL_TEXTURE_2D);
 }
 
@@ -154,9 +568,6 @@ void
 _draw_ball(void)
 {
 	// Ball
-	float angle = 0.0f;
-	const float radius = 0.5f;
-
 	const float colors[] = {
 		1.0f, 0.0f, 0.0f,
 		0.0f, 1.0f, 0.0f,
@@ -171,25 +582,41 @@ _draw_ball(void)
 		1.0f, 1.0f, 0.0f,
 	};
 
-	const int num_colors = sizeof(colors) / (3 * sizeof(float));
-
-	static int color_stride = 0;
-	static int old_time = 0;
-
-	int curr_time = glutGet(GLUT_ELAPSED_TIME);
-	if(curr_time - old_time > 50) {
-		old_time = curr_time;
-		color_stride = (color_stride + 3) % (6 * 3);
+	// Segment count follows the size of the ball on screen
+	float pixel_radius = lod_pixel_radius(sg_world(ball_node) + 12, ball_radius);
+	int level = lod_circle_select(&ball_lod, pixel_radius);
+	int segments = lod_circle_segments(level);
+	const float *circle = lod_circle_table(level);
+
+	if(ball_program && shader_enabled()) {
+		shader_use(ball_program);
+		shader_uniform3fv(ball_palette_uniform, 6, colors);
+		shader_uniform1f(ball_first_color_uniform, (float)(ball_color_stride / 3));
+		shader_uniform1f(ball_segments_uniform, (float)segments);
+
+		sg_load(ball_node);
+			glBegin(GL_QUADS);
+				glTexCoord2f(-1.0f, -1.0f);
+				glVertex2f(-ball_radius, -ball_radius);
+				glTexCoord2f(1.0f, -1.0f);
+				glVertex2f(ball_radius, -ball_radius);
+				glTexCoord2f(1.0f, 1.0f);
+				glVertex2f(ball_radius, ball_radius);
+				glTexCoord2f(-1.0f, 1.0f);
+				glVertex2f(-ball_radius, ball_radius);
+			glEnd();
+		glLoadIdentity();
+		shader_use(0);
+		return;
 	}
 
-	glPushMatrix();
-		glTranslatef(bx, by, 0.25f);
+	sg_load(ball_node);
 		glBegin(GL_TRIANGLE_FAN);
 		glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 		glVertex2f(0.0f, 0.0f);
 
-		int current_color = color_stride;
-		for(angle = 0.0f; angle < 360.0f; angle += 0.25f) {
+		int current_color = ball_color_stride;
+		for(int i = 0; i <= segments; i++) {
 			glColor4f(
 				colors[current_color],
 				colors[current_color + 1],
@@ -197,30 +624,163 @@ _draw_ball(void)
 				0.02f
 			);
 			glVertex2f(
-				radius * cosf(angle),
-				radius * sinf(angle)
+				ball_radius * circle[i * 2],
+				ball_radius * circle[i * 2 + 1]
 			);
 			current_color = (current_color + 3) % (6 * 3);
 		}
 		glEnd();
-	glPopMatrix();
+	glLoadIdentity();
 }
 
 void
-scene_draw(void)
+_draw_teapot(void)
 {
-	//_draw_rectangle();
-	_draw_ball();
-
-	// Teapot
-	glEnable(GL_LIGHTING);
-	glEnable(GL_LIGHT0);
-	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-	glPushMatrix();
-		glTranslatef(0.0f, 0.0f, teapot_z);
-		glRotatef(teapot_angle, 0.0f, 1.0f, 0.0f);
-		glutSolidTeapot(0.3f);
-	glPopMatrix();
+	if(lighting_level > 0) {
+		glEnable(GL_LIGHTING);
+		glEnable(GL_LIGHT0);
+		glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	} else {
+		glColor4f(0.7f, 0.7f, 0.7f, 1.0f);
+	}
+
+	float pixel_radius = lod_pixel_radius(sg_world(teapot_node) + 12, teapot_mesh.radius);
+	mesh_lod_select(&teapot_mesh, pixel_radius);
+
+	sg_load(teapot_node);
+		mesh_lod_draw(&teapot_mesh);
+	glLoadIdentity();
 	glDisable(GL_LIGHTING);
 	glDisable(GL_LIGHT0);
 }
+
+static float
+_axis(unsigned int buttons, int negative, int positive)
+{
+	return (float)((buttons >> positive) & 1) - (float)((buttons >> negative) & 1);
+}
+
+void
+scene_late_latch(void)
+{
+	// Buttons the last tick moved with, and the ones held right now
+	unsigned int simulated = kbdGetButtons() | kbdGetPressed();
+	unsigned int live = kbdPeekButtons();
+
+	if(live == simulated)
+		return;
+
+	// Show the rectangle where the last tick would have put it with
+	// the newer input. Only the drawn transform changes; the next tick
+	// simulates from the real position and resets the node.
+	float dx = _axis(live, BTN_LEFT, BTN_RIGHT) - _axis(simulated, BTN_LEFT, BTN_RIGHT);
+	float dy = _axis(live, BTN_DOWN, BTN_UP) - _axis(simulated, BTN_DOWN, BTN_UP);
+	sg_set_translation(rect_node, x + dx * rect_step, y + dy * rect_step, 0.0f);
+}
+
+static void
+_set_bounds(int drawable, int node, float radius)
+{
+	const float *world = sg_world(node);
+	bound_x[drawable] = world[12];
+	bound_y[drawable] = world[13];
+	bound_z[drawable] = world[14];
+	bound_r[drawable] = radius;
+}
+
+void
+scene_draw(void)
+{
+	sg_update();
+
+	_set_bounds(DRAW_RECTANGLE, rect_node, rect_half * 1.4143f);
+	_set_bounds(DRAW_BALL, ball_node, ball_radius);
+	_set_bounds(DRAW_TEAPOT, teapot_node, teapot_mesh.radius);
+
+	cull_begin_frame();
+	lod_begin_frame();
+	mesh_begin_frame();
+	cull_spheres(bound_x, bound_y, bound_z, bound_r, NUM_DRAWABLES, visible);
+
+	if(show_backdrop)
+		layer_cache_draw(&backdrop_layer);
+	if(visible[DRAW_RECTANGLE])
+		_draw_rectangle();
+	if(visible[DRAW_BALL])
+		_draw_ball();
+	if(visible[DRAW_TEAPOT])
+		_draw_teapot();
+	cull_end_frame();
+	mesh_end_frame();
+
+	static int particle_zone = profile_zone("particles");
+	ProfileScope scope(particle_zone);
+	particle_draw(&stress);
+	particle_draw(&sparks);
+}
+
+void
+scene_show_bounds(bool show)
+{
+	show_bounds = show;
+}
+
+bool
+scene_bounds_shown(void)
+{
+	return show_bounds;
+}
+
+void
+scene_draw_bounds(void)
+{
+	if(!show_bounds)
+		return;
+
+	// Clip space to pixels; projection is identity
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	float half_w = viewport[2] * 0.5f;
+	float half_h = viewport[3] * 0.5f;
+
+	shape_begin(&bounds_batch);
+
+	shape_set_blend(&bounds_batch, SHAPE_BLEND_ADDITIVE);
+	for(int i = 0; i < NUM_BODIES; i++) {
+		const SpatialBox &box = bodies[i];
+		shape_rect(&bounds_batch,
+		           (box.minx + 1.0f) * half_w, (1.0f - box.maxy) * half_h,
+		           (box.maxx - box.minx) * half_w, (box.maxy - box.miny) * half_h,
+		           6.0f, 0x4080ff30);
+	}
+
+	shape_set_blend(&bounds_batch, SHAPE_BLEND_ALPHA);
+	for(int i = 0; i < NUM_DRAWABLES; i++) {
+		float cx = (bound_x[i] + 1.0f) * half_w;
+		float cy = (1.0f - bound_y[i]) * half_h;
+		unsigned int color = visible[i] ? 0x40ff40c0 : 0xff4040c0;
+		shape_circle_outline(&bounds_batch, cx, cy, bound_r[i] * half_w, 1.5f, color);
+		shape_circle(&bounds_batch, cx, cy, 3.0f, color);
+	}
+
+	// Where the ball is heading
+	float heading[4] = {
+		(bx + 1.0f) * half_w, (1.0f - by) * half_h,
+		(bx + bsx * 0.25f + 1.0f) * half_w, (1.0f - by - bsy * 0.25f) * half_h,
+	};
+	shape_polyline(&bounds_batch, heading, 2, 2.0f, false, 0xffff40c0);
+
+	shape_flush(&bounds_batch);
+}
+
+void
+scene_show_tilemap(bool show)
+{
+	show_backdrop = show;
+}
+
+bool
+scene_tilemap_shown(void)
+{
+	return show_backdrop;
+}
@@ -3,7 +3,15 @@
 
 void scene_init(void);
 void scene_update(double dt);
+void scene_late_latch(void);
 void scene_draw(void);
+void scene_draw_bounds(void); // Culling and collision volumes
+void scene_show_bounds(bool show);
+bool scene_bounds_shown(void);
+void scene_set_particle_stress(int count); // Extra live particles, 0 for none
+int  scene_particles_live(void);
+void scene_show_tilemap(bool show);
+bool scene_tilemap_shown(void);
 void scene_dispose(void);
 
 #endif
\ No newline at end of file
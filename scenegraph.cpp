@@ -0,0 +1,206 @@
+#include "scenegraph.hpp"
+#include <cmath>
+#include <cstring>
+#include <GL/gl.h>
+
+#include "log.hpp"
+#include "glstats.hpp"
+
+#define SG_DIRTY   0x1 // Local transform changed
+#define SG_UPDATED 0x2 // World matrix rebuilt on the last pass
+
+static int   num_nodes = 0;
+static int   parents[SG_MAX_NODES];
+static int   flags[SG_MAX_NODES];
+static float translation[SG_MAX_NODES][3];
+static float rotation[SG_MAX_NODES][4]; // angle (degrees), axis
+static float scale[SG_MAX_NODES];
+static float local[SG_MAX_NODES][16];
+static float world[SG_MAX_NODES][16];
+
+static const float identity[16] = {
+	1.0f, 0.0f, 0.0f, 0.0f,
+	0.0f, 1.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, 1.0f, 0.0f,
+	0.0f, 0.0f, 0.0f, 1.0f,
+};
+
+static bool
+_valid(int node)
+{
+	return node >= 0 && node < num_nodes;
+}
+
+static void
+_mat_identity(float *m)
+{
+	memset(m, 0, 16 * sizeof(float));
+	m[0] = m[5] = m[10] = m[15] = 1.0f;
+}
+
+// out = a * b, column-major. out must not alias a or b.
+static void
+_mat_mul(float *out, const float *a, const float *b)
+{
+	for(int c = 0; c < 4; c++) {
+		for(int r = 0; r < 4; r++) {
+			out[c * 4 + r] =
+				a[0 * 4 + r] * b[c * 4 + 0] +
+				a[1 * 4 + r] * b[c * 4 + 1] +
+				a[2 * 4 + r] * b[c * 4 + 2] +
+				a[3 * 4 + r] * b[c * 4 + 3];
+		}
+	}
+}
+
+// local = T * R * S, same order as glTranslatef + glRotatef + glScalef
+static void
+_build_local(int n)
+{
+	float *m = local[n];
+	float ax = rotation[n][1], ay = rotation[n][2], az = rotation[n][3];
+	float len = sqrtf(ax * ax + ay * ay + az * az);
+	float s = scale[n];
+
+	_mat_identity(m);
+	if(len > 0.0f && rotation[n][0] != 0.0f) {
+		float rad = rotation[n][0] * 3.14159265f / 180.0f;
+		float c = cosf(rad), si = sinf(rad), t = 1.0f - c;
+		ax /= len; ay /= len; az /= len;
+
+		m[0] = t * ax * ax + c;
+		m[1] = t * ax * ay + si * az;
+		m[2] = t * ax * az - si * ay;
+		m[4] = t * ax * ay - si * az;
+		m[5] = t * ay * ay + c;
+		m[6] = t * ay * az + si * ax;
+		m[8] = t * ax * az + si * ay;
+		m[9] = t * ay * az - si * ax;
+		m[10] = t * az * az + c;
+	}
+
+	for(int i = 0; i < 3; i++) {
+		m[i]     *= s;
+		m[4 + i] *= s;
+		m[8 + i] *= s;
+	}
+
+	m[12] = translation[n][0];
+	m[13] = translation[n][1];
+	m[14] = translation[n][2];
+}
+
+void
+sg_reset(void)
+{
+	num_nodes = 0;
+}
+
+int
+sg_create(int parent)
+{
+	if(num_nodes >= SG_MAX_NODES) {
+		log_error("sg: more than %d nodes", SG_MAX_NODES);
+		return SG_INVALID;
+	}
+	// Parents must come first for the single pass update
+	if(parent != SG_ROOT && !_valid(parent)) {
+		log_error("sg: no node %d to parent to", parent);
+		return SG_INVALID;
+	}
+
+	int n = num_nodes++;
+	parents[n] = parent;
+	flags[n] = SG_DIRTY;
+	translation[n][0] = translation[n][1] = translation[n][2] = 0.0f;
+	rotation[n][0] = rotation[n][1] = rotation[n][2] = 0.0f;
+	rotation[n][3] = 1.0f;
+	scale[n] = 1.0f;
+	return n;
+}
+
+int
+sg_count(void)
+{
+	return num_nodes;
+}
+
+int
+sg_parent(int node)
+{
+	return _valid(node) ? parents[node] : SG_ROOT;
+}
+
+// Setters run every tick; only actual changes dirty the node
+void
+sg_set_translation(int node, float x, float y, float z)
+{
+	if(!_valid(node))
+		return;
+	float *t = translation[node];
+	if(t[0] == x && t[1] == y && t[2] == z)
+		return;
+	t[0] = x;
+	t[1] = y;
+	t[2] = z;
+	flags[node] |= SG_DIRTY;
+}
+
+void
+sg_set_rotation(int node, float angle, float ax, float ay, float az)
+{
+	if(!_valid(node))
+		return;
+	float *r = rotation[node];
+	if(r[0] == angle && r[1] == ax && r[2] == ay && r[3] == az)
+		return;
+	r[0] = angle;
+	r[1] = ax;
+	r[2] = ay;
+	r[3] = az;
+	flags[node] |= SG_DIRTY;
+}
+
+void
+sg_set_scale(int node, float s)
+{
+	if(!_valid(node) || scale[node] == s)
+		return;
+	scale[node] = s;
+	flags[node] |= SG_DIRTY;
+}
+
+void
+sg_update(void)
+{
+	for(int n = 0; n < num_nodes; n++) {
+		int p = parents[n];
+		bool parent_updated = (p != SG_ROOT) && (flags[p] & SG_UPDATED);
+
+		if(!(flags[n] & SG_DIRTY) && !parent_updated) {
+			flags[n] &= ~SG_UPDATED;
+			continue;
+		}
+
+		if(flags[n] & SG_DIRTY)
+			_build_local(n);
+
+		if(p == SG_ROOT)
+			memcpy(world[n], local[n], 16 * sizeof(float));
+		else _mat_mul(world[n], world[p], local[n]);
+
+		flags[n] = SG_UPDATED;
+	}
+}
+
+const float *
+sg_world(int node)
+{
+	return _valid(node) ? world[node] : identity;
+}
+
+void
+sg_load(int node)
+{
+	glLoadMatrixf(sg_world(node));
+}
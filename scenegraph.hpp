@@ -0,0 +1,29 @@
+#ifndef SCENEGRAPH_HPP_INCLUDED
+#define SCENEGRAPH_HPP_INCLUDED
+
+// Flat scene graph. Nodes live in arrays ordered so that a
+// parent always comes before its children, so world matrices
+// can be rebuilt in a single forward pass. Only nodes whose
+// local transform changed (and their descendants) are recomputed.
+// Matrices are column-major, ready for glLoadMatrixf.
+//
+// sg_create returns SG_INVALID when the pool is full or the parent
+// does not exist yet. Setters ignore it, and sg_world/sg_load treat
+// it as identity.
+
+#define SG_MAX_NODES 256
+#define SG_ROOT      -1
+#define SG_INVALID   -2
+
+void         sg_reset(void);
+int          sg_create(int parent);
+int          sg_count(void);
+int          sg_parent(int node);
+void         sg_set_translation(int node, float x, float y, float z);
+void         sg_set_rotation(int node, float angle, float ax, float ay, float az);
+void         sg_set_scale(int node, float s);
+void         sg_update(void);
+const float *sg_world(int node);
+void         sg_load(int node);
+
+#endif // SCENEGRAPH_HPP_INCLUDED
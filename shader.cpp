@@ -0,0 +1,234 @@
+#include "shader.hpp"
+#include <cstddef>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+
+#include "log.hpp"
+#include "render.hpp"
+#include "gltrace.hpp"
+
+// Same values for the GL 2.0 names and the ARB_shader_objects ones
+#define SHADER_FRAGMENT    0x8B30
+#define SHADER_VERTEX      0x8B31
+#define SHADER_COMPILED    0x8B81
+#define SHADER_LINKED      0x8B82
+
+// GLhandleARB is an unsigned int everywhere this builds, so the
+// ARB entry points fit the GL 2.0 signatures
+typedef GLuint (APIENTRY *CreateShaderProc)(GLenum type);
+typedef void   (APIENTRY *ShaderSourceProc)(GLuint shader, GLsizei count,
+                                            const char **source, const GLint *length);
+typedef void   (APIENTRY *CompileShaderProc)(GLuint shader);
+typedef GLuint (APIENTRY *CreateProgramProc)(void);
+typedef void   (APIENTRY *AttachShaderProc)(GLuint program, GLuint shader);
+typedef void   (APIENTRY *LinkProgramProc)(GLuint program);
+typedef void   (APIENTRY *UseProgramProc)(GLuint program);
+typedef void   (APIENTRY *DeleteObjectProc)(GLuint object);
+typedef void   (APIENTRY *GetObjectivProc)(GLuint object, GLenum name, GLint *value);
+typedef void   (APIENTRY *GetInfoLogProc)(GLuint object, GLsizei size,
+                                          GLsizei *length, char *log);
+typedef GLint  (APIENTRY *GetUniformLocationProc)(GLuint program, const char *name);
+typedef void   (APIENTRY *Uniform1fProc)(GLint location, GLfloat value);
+typedef void   (APIENTRY *Uniform3fvProc)(GLint location, GLsizei count,
+                                          const GLfloat *values);
+
+static CreateShaderProc       create_shader;
+static ShaderSourceProc       shader_source;
+static CompileShaderProc      compile_shader;
+static CreateProgramProc      create_program;
+static AttachShaderProc       attach_shader;
+static LinkProgramProc        link_program;
+static UseProgramProc         use_program;
+static DeleteObjectProc       delete_shader;
+static DeleteObjectProc       delete_program;
+static GetObjectivProc        get_shader_iv;
+static GetObjectivProc        get_program_iv;
+static GetInfoLogProc         get_shader_log;
+static GetInfoLogProc         get_program_log;
+static GetUniformLocationProc get_uniform_location;
+static Uniform1fProc          uniform1f;
+static Uniform3fvProc         uniform3fv;
+
+static bool available = false;
+static bool enabled   = true;
+
+static bool
+_load_core(void)
+{
+	create_shader        = (CreateShaderProc)render_proc_address("glCreateShader");
+	shader_source        = (ShaderSourceProc)render_proc_address("glShaderSource");
+	compile_shader       = (CompileShaderProc)render_proc_address("glCompileShader");
+	create_program       = (CreateProgramProc)render_proc_address("glCreateProgram");
+	attach_shader        = (AttachShaderProc)render_proc_address("glAttachShader");
+	link_program         = (LinkProgramProc)render_proc_address("glLinkProgram");
+	use_program          = (UseProgramProc)render_proc_address("glUseProgram");
+	delete_shader        = (DeleteObjectProc)render_proc_address("glDeleteShader");
+	delete_program       = (DeleteObjectProc)render_proc_address("glDeleteProgram");
+	get_shader_iv        = (GetObjectivProc)render_proc_address("glGetShaderiv");
+	get_program_iv       = (GetObjectivProc)render_proc_address("glGetProgramiv");
+	get_shader_log       = (GetInfoLogProc)render_proc_address("glGetShaderInfoLog");
+	get_program_log      = (GetInfoLogProc)render_proc_address("glGetProgramInfoLog");
+	get_uniform_location = (GetUniformLocationProc)render_proc_address("glGetUniformLocation");
+	uniform1f            = (Uniform1fProc)render_proc_address("glUniform1f");
+	uniform3fv           = (Uniform3fvProc)render_proc_address("glUniform3fv");
+	return create_shader && shader_source && compile_shader && create_program
+		&& attach_shader && link_program && use_program && delete_shader
+		&& delete_program && get_shader_iv && get_program_iv && get_shader_log
+		&& get_program_log && get_uniform_location && uniform1f && uniform3fv;
+}
+
+static bool
+_load_arb(void)
+{
+	create_shader        = (CreateShaderProc)render_proc_address("glCreateShaderObjectARB");
+	shader_source        = (ShaderSourceProc)render_proc_address("glShaderSourceARB");
+	compile_shader       = (CompileShaderProc)render_proc_address("glCompileShaderARB");
+	create_program       = (CreateProgramProc)render_proc_address("glCreateProgramObjectARB");
+	attach_shader        = (AttachShaderProc)render_proc_address("glAttachObjectARB");
+	link_program         = (LinkProgramProc)render_proc_address("glLinkProgramARB");
+	use_program          = (UseProgramProc)render_proc_address("glUseProgramObjectARB");
+	delete_shader        = (DeleteObjectProc)render_proc_address("glDeleteObjectARB");
+	delete_program       = delete_shader;
+	get_shader_iv        = (GetObjectivProc)render_proc_address("glGetObjectParameterivARB");
+	get_program_iv       = get_shader_iv;
+	get_shader_log       = (GetInfoLogProc)render_proc_address("glGetInfoLogARB");
+	get_program_log      = get_shader_log;
+	get_uniform_location = (GetUniformLocationProc)render_proc_address("glGetUniformLocationARB");
+	uniform1f            = (Uniform1fProc)render_proc_address("glUniform1fARB");
+	uniform3fv           = (Uniform3fvProc)render_proc_address("glUniform3fvARB");
+	return create_shader && shader_source && compile_shader && create_program
+		&& attach_shader && link_program && use_program && delete_shader
+		&& get_shader_iv && get_shader_log && get_uniform_location
+		&& uniform1f && uniform3fv;
+}
+
+bool
+shader_init(void)
+{
+	available = false;
+
+	// Replays have no shaders: captures must stay fixed function
+	if(gltrace_on) {
+		log_info("shader: fixed function while capturing");
+		return false;
+	}
+
+	if(render_gl_version() >= 20)
+		available = _load_core();
+	if(!available
+	   && render_has_extension("GL_ARB_shader_objects")
+	   && render_has_extension("GL_ARB_vertex_shader")
+	   && render_has_extension("GL_ARB_fragment_shader")
+	   && render_has_extension("GL_ARB_shading_language_100"))
+		available = _load_arb();
+
+	if(!available)
+		log_info("shader: no GLSL support, using fixed function");
+	return available;
+}
+
+bool
+shader_available(void)
+{
+	return available;
+}
+
+void
+shader_enable(bool enable)
+{
+	enabled = enable;
+}
+
+bool
+shader_enabled(void)
+{
+	return available && enabled;
+}
+
+static GLuint
+_compile(GLenum type, const char *source)
+{
+	GLuint shader = create_shader(type);
+	GLint compiled = 0;
+	shader_source(shader, 1, &source, NULL);
+	compile_shader(shader);
+	get_shader_iv(shader, SHADER_COMPILED, &compiled);
+	if(!compiled) {
+		char info[LOG_TEXT_BYTES];
+		get_shader_log(shader, sizeof(info), NULL, info);
+		log_error("shader: compile failed: %s", info);
+		delete_shader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+unsigned int
+shader_program(const char *vertex, const char *fragment)
+{
+	if(!available)
+		return 0;
+
+	GLuint vs = _compile(SHADER_VERTEX, vertex);
+	GLuint fs = _compile(SHADER_FRAGMENT, fragment);
+	if(!vs || !fs) {
+		if(vs) delete_shader(vs);
+		if(fs) delete_shader(fs);
+		return 0;
+	}
+
+	GLuint program = create_program();
+	GLint linked = 0;
+	attach_shader(program, vs);
+	attach_shader(program, fs);
+	link_program(program);
+	// Flagged for deletion, freed along with the program
+	delete_shader(vs);
+	delete_shader(fs);
+
+	get_program_iv(program, SHADER_LINKED, &linked);
+	if(!linked) {
+		char info[LOG_TEXT_BYTES];
+		get_program_log(program, sizeof(info), NULL, info);
+		log_error("shader: link failed: %s", info);
+		delete_program(program);
+		return 0;
+	}
+	return program;
+}
+
+void
+shader_free(unsigned int program)
+{
+	if(available && program)
+		delete_program(program);
+}
+
+void
+shader_use(unsigned int program)
+{
+	if(available)
+		use_program(program);
+}
+
+int
+shader_uniform(unsigned int program, const char *name)
+{
+	return available ? get_uniform_location(program, name) : -1;
+}
+
+void
+shader_uniform1f(int location, float value)
+{
+	if(available)
+		uniform1f(location, value);
+}
+
+void
+shader_uniform3fv(int location, int count, const float *values)
+{
+	if(available)
+		uniform3fv(location, count, values);
+}
@@ -0,0 +1,22 @@
+#ifndef SHADER_HPP_INCLUDED
+#define SHADER_HPP_INCLUDED
+
+// GLSL programs through GL 2.0 or the ARB shader object extensions.
+// Entry points are looked up at runtime, so the game still builds
+// against a GL 1.1 header and runs on drivers without shaders: when
+// shader_init finds no support, shader_available stays false and
+// callers keep their fixed-function path.
+
+bool         shader_init(void); // After the context is current
+bool         shader_available(void);
+void         shader_enable(bool enable); // Off forces fixed function
+bool         shader_enabled(void); // Available and not switched off
+
+unsigned int shader_program(const char *vertex, const char *fragment); // 0 on error
+void         shader_free(unsigned int program);
+void         shader_use(unsigned int program); // 0 goes back to fixed function
+int          shader_uniform(unsigned int program, const char *name);
+void         shader_uniform1f(int location, float value);
+void         shader_uniform3fv(int location, int count, const float *values);
+
+#endif // SHADER_HPP_INCLUDED
@@ -0,0 +1,344 @@
+#include "shape.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <GL/gl.h>
+
+#include "utils.hpp"
+#include "lod.hpp"
+#include "memory.hpp"
+#include "glstats.hpp"
+
+#define MITER_LIMIT 4.0f
+
+// Outline of the shape being added, with the outward normal of every
+// point scaled so that offsetting by d along it moves edges by d
+static float path_x[SHAPE_MAX_PATH], path_y[SHAPE_MAX_PATH];
+static float normal_x[SHAPE_MAX_PATH], normal_y[SHAPE_MAX_PATH];
+
+// Quarter turns, for corners too small to be worth an arc
+static const float right_angles[] = {
+	1.0f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f
+};
+
+void
+shape_batch_init(ShapeBatch *batch, int max_vertices)
+{
+	lod_init();
+	for(int i = 0; i < SHAPE_BLENDS; i++) {
+		batch->vertices[i] = (ShapeVertex*)mem_alloc(max_vertices * sizeof(ShapeVertex));
+		batch->num_vertices[i] = 0;
+	}
+	batch->max_vertices = max_vertices;
+	batch->blend = SHAPE_BLEND_ALPHA;
+	batch->feather = 1.0f;
+	batch->dropped = 0;
+}
+
+void
+shape_batch_free(ShapeBatch *batch)
+{
+	for(int i = 0; i < SHAPE_BLENDS; i++) {
+		mem_free(batch->vertices[i]);
+		batch->vertices[i] = NULL;
+		batch->num_vertices[i] = 0;
+	}
+	batch->max_vertices = 0;
+}
+
+void
+shape_begin(ShapeBatch *batch)
+{
+	for(int i = 0; i < SHAPE_BLENDS; i++)
+		batch->num_vertices[i] = 0;
+	batch->blend = SHAPE_BLEND_ALPHA;
+	batch->dropped = 0;
+}
+
+void
+shape_set_blend(ShapeBatch *batch, ShapeBlend blend)
+{
+	batch->blend = blend;
+}
+
+// Room for a whole shape, or NULL and the shape is dropped
+static ShapeVertex *
+_reserve(ShapeBatch *batch, int count)
+{
+	int *used = &batch->num_vertices[batch->blend];
+	if(*used + count > batch->max_vertices) {
+		batch->dropped++;
+		return NULL;
+	}
+	ShapeVertex *v = batch->vertices[batch->blend] + *used;
+	*used += count;
+	return v;
+}
+
+static inline void
+_put(ShapeVertex *v, float x, float y, unsigned int color, float alpha)
+{
+	v->x = x;
+	v->y = y;
+	v->color[0] = (color >> 24) & 0xff;
+	v->color[1] = (color >> 16) & 0xff;
+	v->color[2] = (color >> 8) & 0xff;
+	v->color[3] = (unsigned char)((color & 0xff) * alpha);
+}
+
+// Quad between the points of the path offset by d0 (alpha a0) and
+// d1 (alpha a1), along the edge from point i to point j
+static ShapeVertex *
+_band(ShapeVertex *v, int i, int j, float d0, float a0, float d1, float a1,
+      unsigned int color)
+{
+	float ix0 = path_x[i] + normal_x[i] * d0, iy0 = path_y[i] + normal_y[i] * d0;
+	float jx0 = path_x[j] + normal_x[j] * d0, jy0 = path_y[j] + normal_y[j] * d0;
+	float ix1 = path_x[i] + normal_x[i] * d1, iy1 = path_y[i] + normal_y[i] * d1;
+	float jx1 = path_x[j] + normal_x[j] * d1, jy1 = path_y[j] + normal_y[j] * d1;
+
+	_put(v++, ix0, iy0, color, a0);
+	_put(v++, jx0, jy0, color, a0);
+	_put(v++, jx1, jy1, color, a1);
+	_put(v++, ix0, iy0, color, a0);
+	_put(v++, jx1, jy1, color, a1);
+	_put(v++, ix1, iy1, color, a1);
+	return v;
+}
+
+// Convex path: a fan from its centroid inset by half the feather,
+// then the rim fading out to half the feather past the outline
+static void
+_fill(ShapeBatch *batch, int n, float inset, unsigned int color)
+{
+	ShapeVertex *v = _reserve(batch, n * 9);
+	if(v == NULL)
+		return;
+
+	float cx = 0.0f, cy = 0.0f;
+	for(int i = 0; i < n; i++) {
+		cx += path_x[i];
+		cy += path_y[i];
+	}
+	cx /= n;
+	cy /= n;
+
+	float half = batch->feather * 0.5f;
+	for(int i = 0; i < n; i++) {
+		int j = (i + 1 < n) ? i + 1 : 0;
+		_put(v++, cx, cy, color, 1.0f);
+		_put(v++, path_x[i] - normal_x[i] * inset, path_y[i] - normal_y[i] * inset, color, 1.0f);
+		_put(v++, path_x[j] - normal_x[j] * inset, path_y[j] - normal_y[j] * inset, color, 1.0f);
+		v = _band(v, i, j, -inset, 1.0f, half, 0.0f, color);
+	}
+}
+
+// Path stroked with the given thickness: a solid core between two
+// feathered rims. Strokes thinner than the feather fade instead.
+static void
+_stroke(ShapeBatch *batch, int n, bool closed, float thickness, unsigned int color)
+{
+	int edges = closed ? n : n - 1;
+	if(edges < 1)
+		return;
+	ShapeVertex *v = _reserve(batch, edges * 18);
+	if(v == NULL)
+		return;
+
+	float half = thickness * 0.5f;
+	float feather = batch->feather * 0.5f;
+	float core = half - feather;
+	float alpha = 1.0f;
+	if(core < 0.0f) {
+		alpha = thickness / batch->feather;
+		core = 0.0f;
+	}
+
+	for(int i = 0; i < edges; i++) {
+		int j = (i + 1 < n) ? i + 1 : 0;
+		v = _band(v, i, j, -half - feather, 0.0f, -core, alpha, color);
+		v = _band(v, i, j, -core, alpha, core, alpha, color);
+		v = _band(v, i, j, core, alpha, half + feather, 0.0f, color);
+	}
+}
+
+static int
+_circle_path(float x, float y, float radius)
+{
+	int level = lod_circle_level(radius);
+	int n = lod_circle_segments(level);
+	const float *circle = lod_circle_table(level);
+
+	for(int i = 0; i < n; i++) {
+		normal_x[i] = circle[i * 2];
+		normal_y[i] = circle[i * 2 + 1];
+		path_x[i] = x + radius * normal_x[i];
+		path_y[i] = y + radius * normal_y[i];
+	}
+	return n;
+}
+
+// Clockwise on screen from the bottom right corner
+static int
+_rect_path(float x, float y, float w, float h, float corner)
+{
+	float limit = (w < h ? w : h) * 0.5f;
+	corner = clamp(corner, 0.0f, limit);
+
+	const float *arc = right_angles;
+	int quarter = 1;
+	if(corner >= 1.0f) {
+		int level = lod_circle_level(corner);
+		while(lod_circle_segments(level) % 4 != 0)
+			level++;
+		arc = lod_circle_table(level);
+		quarter = lod_circle_segments(level) / 4;
+	}
+
+	const float centers[4][2] = {
+		{ x + w - corner, y + h - corner },
+		{ x + corner,     y + h - corner },
+		{ x + corner,     y + corner },
+		{ x + w - corner, y + corner },
+	};
+
+	int n = 0;
+	for(int k = 0; k < 4; k++) {
+		for(int i = k * quarter; i <= (k + 1) * quarter; i++, n++) {
+			normal_x[n] = arc[i * 2];
+			normal_y[n] = arc[i * 2 + 1];
+			path_x[n] = centers[k][0] + corner * normal_x[n];
+			path_y[n] = centers[k][1] + corner * normal_y[n];
+		}
+	}
+	return n;
+}
+
+void
+shape_circle(ShapeBatch *batch, float x, float y, float radius,
+             unsigned int color)
+{
+	int n = _circle_path(x, y, radius);
+	float inset = batch->feather * 0.5f;
+	_fill(batch, n, inset < radius ? inset : radius, color);
+}
+
+void
+shape_circle_outline(ShapeBatch *batch, float x, float y, float radius,
+                     float thickness, unsigned int color)
+{
+	int n = _circle_path(x, y, radius);
+	_stroke(batch, n, true, thickness, color);
+}
+
+void
+shape_rect(ShapeBatch *batch, float x, float y, float w, float h,
+           float corner, unsigned int color)
+{
+	int n = _rect_path(x, y, w, h, corner);
+	float limit = (w < h ? w : h) * 0.5f;
+	float inset = batch->feather * 0.5f;
+	_fill(batch, n, inset < limit ? inset : limit, color);
+}
+
+void
+shape_rect_outline(ShapeBatch *batch, float x, float y, float w, float h,
+                   float corner, float thickness, unsigned int color)
+{
+	int n = _rect_path(x, y, w, h, corner);
+	_stroke(batch, n, true, thickness, color);
+}
+
+void
+shape_polyline(ShapeBatch *batch, const float *points, int count,
+               float thickness, bool closed, unsigned int color)
+{
+	if(count > SHAPE_MAX_PATH)
+		count = SHAPE_MAX_PATH;
+	if(count < 2)
+		return;
+
+	for(int i = 0; i < count; i++) {
+		path_x[i] = points[i * 2];
+		path_y[i] = points[i * 2 + 1];
+	}
+
+	// Segment normals, then miters where two segments meet
+	for(int i = 0; i < count; i++) {
+		int prev = (i > 0) ? i - 1 : (closed ? count - 1 : -1);
+		int next = (i + 1 < count) ? i + 1 : (closed ? 0 : -1);
+
+		float px = 0.0f, py = 0.0f, nx = 0.0f, ny = 0.0f;
+		if(prev >= 0) {
+			float dx = path_x[i] - path_x[prev], dy = path_y[i] - path_y[prev];
+			float length = sqrtf(dx * dx + dy * dy);
+			if(length > 0.0f) {
+				px = -dy / length;
+				py = dx / length;
+			}
+		}
+		if(next >= 0) {
+			float dx = path_x[next] - path_x[i], dy = path_y[next] - path_y[i];
+			float length = sqrtf(dx * dx + dy * dy);
+			if(length > 0.0f) {
+				nx = -dy / length;
+				ny = dx / length;
+			}
+		}
+
+		float mx = px + nx, my = py + ny;
+		float length = sqrtf(mx * mx + my * my);
+		if(length < 0.0001f) { // Ends, or a full turn back
+			mx = (prev >= 0) ? px : nx;
+			my = (prev >= 0) ? py : ny;
+			length = 1.0f;
+		}
+		mx /= length;
+		my /= length;
+
+		// Stretched so the stroke keeps its width through the corner
+		float along = (prev >= 0) ? mx * px + my * py : 1.0f;
+		float scale = (along > 1.0f / MITER_LIMIT) ? 1.0f / along : MITER_LIMIT;
+		normal_x[i] = mx * scale;
+		normal_y[i] = my * scale;
+	}
+
+	_stroke(batch, count, closed, thickness, color);
+}
+
+void
+shape_flush(ShapeBatch *batch)
+{
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	float scale_x = 2.0f / viewport[2];
+	float scale_y = -2.0f / viewport[3];
+
+	glDisable(GL_DEPTH_TEST);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+
+	for(int b = 0; b < SHAPE_BLENDS; b++) {
+		int count = batch->num_vertices[b];
+		ShapeVertex *vertices = batch->vertices[b];
+		if(count == 0)
+			continue;
+
+		// Pixels to clip space; projection and modelview are identity
+		for(int i = 0; i < count; i++) {
+			vertices[i].x = vertices[i].x * scale_x - 1.0f;
+			vertices[i].y = vertices[i].y * scale_y + 1.0f;
+		}
+
+		glBlendFunc(GL_SRC_ALPHA,
+		            b == SHAPE_BLEND_ADDITIVE ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+		glVertexPointer(2, GL_FLOAT, sizeof(ShapeVertex), &vertices[0].x);
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(ShapeVertex), vertices[0].color);
+		glDrawArrays(GL_TRIANGLES, 0, count);
+		batch->num_vertices[b] = 0;
+	}
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,56 @@
+#ifndef SHAPE_HPP_INCLUDED
+#define SHAPE_HPP_INCLUDED
+
+// Batched vector shapes. Circles, rounded rectangles and polylines are
+// tessellated into colored triangles as they are added, with a one
+// pixel feathered rim fading to transparent for antialiasing. Shapes
+// are kept in one vertex stream per blend mode, so shape_flush issues
+// at most one draw call per mode whatever was added. Circle segment
+// counts come from the cached lod tables. Coordinates are in pixels
+// from the top left corner of the viewport, colors are 0xRRGGBBAA.
+
+#define SHAPE_MAX_PATH 1024 // Longest polyline, in points
+
+enum ShapeBlend
+{
+	SHAPE_BLEND_ALPHA,
+	SHAPE_BLEND_ADDITIVE,
+	SHAPE_BLENDS
+};
+
+struct ShapeVertex
+{
+	float         x, y;
+	unsigned char color[4];
+};
+
+struct ShapeBatch
+{
+	ShapeVertex *vertices[SHAPE_BLENDS];
+	int          num_vertices[SHAPE_BLENDS];
+	int          max_vertices; // Per blend mode
+	ShapeBlend   blend;        // Mode new shapes go to
+	float        feather;      // Width of the antialiased rim
+	unsigned int dropped;      // Shapes that did not fit since begin
+};
+
+void shape_batch_init(ShapeBatch *batch, int max_vertices);
+void shape_batch_free(ShapeBatch *batch);
+
+void shape_begin(ShapeBatch *batch);
+void shape_set_blend(ShapeBatch *batch, ShapeBlend blend);
+
+void shape_circle(ShapeBatch *batch, float x, float y, float radius,
+                  unsigned int color);
+void shape_circle_outline(ShapeBatch *batch, float x, float y, float radius,
+                          float thickness, unsigned int color);
+void shape_rect(ShapeBatch *batch, float x, float y, float w, float h,
+                float corner, unsigned int color);
+void shape_rect_outline(ShapeBatch *batch, float x, float y, float w, float h,
+                        float corner, float thickness, unsigned int color);
+void shape_polyline(ShapeBatch *batch, const float *points, int count,
+                    float thickness, bool closed, unsigned int color);
+
+void shape_flush(ShapeBatch *batch);
+
+#endif // SHAPE_HPP_INCLUDED
@@ -0,0 +1,208 @@
+#include "spatial.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "memory.hpp"
+
+struct SpatialEntry
+{
+	int body;
+	int cx, cy;
+};
+
+static float inv_cell      = 1.0f;
+static int   num_buckets   = 0;
+static int  *bucket_start  = NULL; // num_buckets + 1 offsets into entries
+static int  *bucket_fill   = NULL;
+
+static SpatialEntry *entries   = NULL;
+static int num_entries         = 0;
+static int entries_cap         = 0;
+
+static const SpatialBox *bodies = NULL;
+static int num_bodies           = 0;
+static unsigned int *stamps     = NULL;
+static int stamps_cap           = 0;
+static unsigned int stamp       = 0;
+
+static inline int
+_cell(float v)
+{
+	return (int)floorf(v * inv_cell);
+}
+
+static inline int
+_bucket(int cx, int cy)
+{
+	unsigned int h = ((unsigned int)cx * 73856093u)
+		^ ((unsigned int)cy * 19349663u);
+	return (int)(h & (unsigned int)(num_buckets - 1));
+}
+
+static inline bool
+_overlaps(const SpatialBox &a, const SpatialBox &b)
+{
+	return a.minx <= b.maxx && b.minx <= a.maxx
+		&& a.miny <= b.maxy && b.miny <= a.maxy;
+}
+
+void
+spatial_init(float cell_size, int max_bodies)
+{
+	spatial_dispose();
+
+	inv_cell = 1.0f / cell_size;
+
+	// Twice as many buckets as bodies keeps hash
+	// collisions between unrelated cells rare.
+	num_buckets = 64;
+	while(num_buckets < max_bodies * 2)
+		num_buckets <<= 1;
+
+	bucket_start = (int*)mem_alloc((num_buckets + 1) * sizeof(int));
+	bucket_fill  = (int*)mem_alloc(num_buckets * sizeof(int));
+}
+
+void
+spatial_dispose(void)
+{
+	mem_free(bucket_start);
+	mem_free(bucket_fill);
+	mem_free(entries);
+	mem_free(stamps);
+	bucket_start = bucket_fill = NULL;
+	stamps = NULL;
+	entries = NULL;
+	num_buckets = num_entries = entries_cap = 0;
+	num_bodies = stamps_cap = stamp = 0;
+	bodies = NULL;
+}
+
+void
+spatial_build(const SpatialBox *boxes, int count)
+{
+	bodies = boxes;
+	num_bodies = count;
+
+	if(count > stamps_cap) {
+		stamps = (unsigned int*)mem_realloc(stamps, count * sizeof(unsigned int));
+		memset(stamps, 0, count * sizeof(unsigned int));
+		stamps_cap = count;
+		stamp = 0;
+	}
+
+	// Counting sort, pass 1: number of entries per bucket.
+	// Bodies larger than a cell are inserted in every cell they touch.
+	memset(bucket_start, 0, (num_buckets + 1) * sizeof(int));
+	int total = 0;
+	for(int i = 0; i < count; i++) {
+		int x0 = _cell(boxes[i].minx), x1 = _cell(boxes[i].maxx);
+		int y0 = _cell(boxes[i].miny), y1 = _cell(boxes[i].maxy);
+		for(int cy = y0; cy <= y1; cy++) {
+			for(int cx = x0; cx <= x1; cx++) {
+				bucket_start[_bucket(cx, cy) + 1]++;
+				total++;
+			}
+		}
+	}
+
+	if(total > entries_cap) {
+		entries_cap = total + total / 2;
+		entries = (SpatialEntry*)mem_realloc(
+			entries, entries_cap * sizeof(SpatialEntry));
+	}
+	num_entries = total;
+
+	for(int b = 0; b < num_buckets; b++) {
+		bucket_start[b + 1] += bucket_start[b];
+		bucket_fill[b] = bucket_start[b];
+	}
+
+	// Pass 2: scatter entries into their bucket ranges
+	for(int i = 0; i < count; i++) {
+		int x0 = _cell(boxes[i].minx), x1 = _cell(boxes[i].maxx);
+		int y0 = _cell(boxes[i].miny), y1 = _cell(boxes[i].maxy);
+		for(int cy = y0; cy <= y1; cy++) {
+			for(int cx = x0; cx <= x1; cx++) {
+				SpatialEntry &e = entries[bucket_fill[_bucket(cx, cy)]++];
+				e.body = i;
+				e.cx = cx;
+				e.cy = cy;
+			}
+		}
+	}
+}
+
+int
+spatial_pairs(SpatialPairFunc func, void *data)
+{
+	int found = 0;
+
+	for(int b = 0; b < num_buckets; b++) {
+		int end = bucket_start[b + 1];
+		for(int i = bucket_start[b]; i < end; i++) {
+			const SpatialEntry &ea = entries[i];
+			const SpatialBox &a = bodies[ea.body];
+			for(int j = i + 1; j < end; j++) {
+				const SpatialEntry &eb = entries[j];
+				// Buckets may hold several cells due to hash collisions
+				if(ea.cx != eb.cx || ea.cy != eb.cy)
+					continue;
+
+				const SpatialBox &c = bodies[eb.body];
+				if(!_overlaps(a, c))
+					continue;
+
+				// A pair sharing many cells is only reported by the
+				// cell holding the lower corner of their overlap.
+				float ox = a.minx > c.minx ? a.minx : c.minx;
+				float oy = a.miny > c.miny ? a.miny : c.miny;
+				if(_cell(ox) != ea.cx || _cell(oy) != ea.cy)
+					continue;
+
+				if(ea.body < eb.body)
+					func(ea.body, eb.body, data);
+				else func(eb.body, ea.body, data);
+				found++;
+			}
+		}
+	}
+
+	return found;
+}
+
+int
+spatial_query(const SpatialBox *region, int *out, int max_out)
+{
+	int found = 0;
+	int x0 = _cell(region->minx), x1 = _cell(region->maxx);
+	int y0 = _cell(region->miny), y1 = _cell(region->maxy);
+
+	// Zero never marks a body, so old marks cannot match after a wrap
+	if(++stamp == 0) {
+		memset(stamps, 0, stamps_cap * sizeof(unsigned int));
+		stamp = 1;
+	}
+
+	for(int cy = y0; cy <= y1; cy++) {
+		for(int cx = x0; cx <= x1; cx++) {
+			int b = _bucket(cx, cy);
+			int end = bucket_start[b + 1];
+			for(int i = bucket_start[b]; i < end; i++) {
+				const SpatialEntry &e = entries[i];
+				if(e.cx != cx || e.cy != cy || stamps[e.body] == stamp)
+					continue;
+				stamps[e.body] = stamp;
+
+				if(!_overlaps(bodies[e.body], *region))
+					continue;
+				if(found < max_out)
+					out[found] = e.body;
+				found++;
+			}
+		}
+	}
+
+	return found < max_out ? found : max_out;
+}
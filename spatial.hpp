@@ -0,0 +1,23 @@
+#ifndef SPATIAL_HPP_INCLUDED
+#define SPATIAL_HPP_INCLUDED
+
+// Uniform spatial hash used as collision broadphase.
+// Bodies are rebuilt every tick from their bounding boxes
+// and sorted by cell with a counting sort, so queries only
+// need to look at the entries of the cells they touch.
+
+struct SpatialBox
+{
+	float minx, miny;
+	float maxx, maxy;
+};
+
+typedef void (*SpatialPairFunc)(int a, int b, void *data);
+
+void spatial_init(float cell_size, int max_bodies);
+void spatial_dispose(void);
+void spatial_build(const SpatialBox *boxes, int count);
+int  spatial_pairs(SpatialPairFunc func, void *data);
+int  spatial_query(const SpatialBox *region, int *out, int max_out);
+
+#endif // SPATIAL_HPP_INCLUDED
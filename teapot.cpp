@@ -0,0 +1,235 @@
+#include "teapot.hpp"
+#include <cmath>
+#include <cstdlib>
+
+#include "memory.hpp"
+
+// Patch subdivisions per level, and the on-screen radius in pixels
+// from which each level is used.
+static const int   level_grid[MESH_MAX_LEVELS]   = { 10, 6, 4, 2 };
+static const float level_pixels[MESH_MAX_LEVELS] = { 120.0f, 60.0f, 25.0f, 0.0f };
+
+// Teapot data, Z up. The body, lid and bottom are surfaces of
+// revolution: each is given as four (radius, height) profile points
+// and swept around a quarter circle four times. Handle and spout are
+// given as full 4x4 patches for the y <= 0 half and mirrored.
+#define NUM_PROFILES 6
+#define NUM_HALVES   4
+
+static const float profiles[NUM_PROFILES][4][2] = {
+	// Rim
+	{ {1.4f, 2.4f}, {1.3375f, 2.53125f}, {1.4375f, 2.53125f}, {1.5f, 2.4f} },
+	// Body
+	{ {1.5f, 2.4f}, {1.75f, 1.875f}, {2.0f, 1.35f}, {2.0f, 0.9f} },
+	{ {2.0f, 0.9f}, {2.0f, 0.45f}, {1.5f, 0.225f}, {1.5f, 0.15f} },
+	// Lid
+	{ {0.0f, 3.15f}, {0.8f, 3.15f}, {0.0f, 2.85f}, {0.2f, 2.7f} },
+	{ {0.2f, 2.7f}, {0.4f, 2.55f}, {1.3f, 2.55f}, {1.3f, 2.4f} },
+	// Bottom
+	{ {0.0f, 0.0f}, {1.425f, 0.0f}, {1.5f, 0.075f}, {1.5f, 0.15f} },
+};
+
+// The bottom is swept the other way around so it faces down
+static const bool profile_flip[NUM_PROFILES] = {
+	false, false, false, false, false, true
+};
+
+static const float halves[NUM_HALVES][4][4][3] = {
+	// Handle
+	{
+		{ {-1.6f, 0.0f, 2.025f}, {-1.6f, -0.3f, 2.025f}, {-1.5f, -0.3f, 2.25f}, {-1.5f, 0.0f, 2.25f} },
+		{ {-2.3f, 0.0f, 2.025f}, {-2.3f, -0.3f, 2.025f}, {-2.5f, -0.3f, 2.25f}, {-2.5f, 0.0f, 2.25f} },
+		{ {-2.7f, 0.0f, 2.025f}, {-2.7f, -0.3f, 2.025f}, {-3.0f, -0.3f, 2.25f}, {-3.0f, 0.0f, 2.25f} },
+		{ {-2.7f, 0.0f, 1.8f},   {-2.7f, -0.3f, 1.8f},   {-3.0f, -0.3f, 1.8f},  {-3.0f, 0.0f, 1.8f} },
+	},
+	{
+		{ {-2.7f, 0.0f, 1.8f},   {-2.7f, -0.3f, 1.8f},   {-3.0f, -0.3f, 1.8f},     {-3.0f, 0.0f, 1.8f} },
+		{ {-2.7f, 0.0f, 1.575f}, {-2.7f, -0.3f, 1.575f}, {-3.0f, -0.3f, 1.35f},    {-3.0f, 0.0f, 1.35f} },
+		{ {-2.5f, 0.0f, 0.975f}, {-2.5f, -0.3f, 0.975f}, {-2.65f, -0.3f, 0.7875f}, {-2.65f, 0.0f, 0.7875f} },
+		{ {-2.0f, 0.0f, 0.45f},  {-2.0f, -0.3f, 0.45f},  {-1.9f, -0.3f, 0.6f},     {-1.9f, 0.0f, 0.6f} },
+	},
+	// Spout
+	{
+		{ {1.7f, 0.0f, 1.425f}, {1.7f, -0.66f, 1.425f}, {1.7f, -0.66f, 0.6f},   {1.7f, 0.0f, 0.6f} },
+		{ {2.6f, 0.0f, 1.425f}, {2.6f, -0.66f, 1.425f}, {3.1f, -0.66f, 0.825f}, {3.1f, 0.0f, 0.825f} },
+		{ {2.3f, 0.0f, 2.1f},   {2.3f, -0.25f, 2.1f},   {2.4f, -0.25f, 2.025f}, {2.4f, 0.0f, 2.025f} },
+		{ {2.7f, 0.0f, 2.4f},   {2.7f, -0.25f, 2.4f},   {3.3f, -0.25f, 2.4f},   {3.3f, 0.0f, 2.4f} },
+	},
+	{
+		{ {2.7f, 0.0f, 2.4f},     {2.7f, -0.25f, 2.4f},     {3.3f, -0.25f, 2.4f},       {3.3f, 0.0f, 2.4f} },
+		{ {2.8f, 0.0f, 2.475f},   {2.8f, -0.25f, 2.475f},   {3.525f, -0.25f, 2.49375f}, {3.525f, 0.0f, 2.49375f} },
+		{ {2.9f, 0.0f, 2.475f},   {2.9f, -0.15f, 2.475f},   {3.45f, -0.15f, 2.5125f},   {3.45f, 0.0f, 2.5125f} },
+		{ {2.8f, 0.0f, 2.4f},     {2.8f, -0.15f, 2.4f},     {3.2f, -0.15f, 2.4f},       {3.2f, 0.0f, 2.4f} },
+	},
+};
+
+// Control points of the quarter circle arc, from +x towards -y
+static const float kappa = 0.56f;
+
+// 4 quarters per revolved profile, 2 mirrored halves per patch
+#define NUM_PATCHES (NUM_PROFILES * 4 + NUM_HALVES * 2)
+
+static void
+_bernstein(float t, float *b, float *db)
+{
+	float s = 1.0f - t;
+	b[0] = s * s * s;
+	b[1] = 3.0f * t * s * s;
+	b[2] = 3.0f * t * t * s;
+	b[3] = t * t * t;
+	db[0] = -3.0f * s * s;
+	db[1] = 3.0f * s * s - 6.0f * t * s;
+	db[2] = 6.0f * t * s - 3.0f * t * t;
+	db[3] = 3.0f * t * t;
+}
+
+// Position and (dv x du) normal of a patch at (u, v)
+static void
+_eval(const float cp[4][4][3], float u, float v, float *pos, float *normal)
+{
+	float bu[4], dbu[4], bv[4], dbv[4];
+	float du[3] = { 0.0f, 0.0f, 0.0f };
+	float dv[3] = { 0.0f, 0.0f, 0.0f };
+
+	_bernstein(u, bu, dbu);
+	_bernstein(v, bv, dbv);
+
+	pos[0] = pos[1] = pos[2] = 0.0f;
+	for(int i = 0; i < 4; i++) {
+		for(int j = 0; j < 4; j++) {
+			for(int k = 0; k < 3; k++) {
+				pos[k] += bu[i] * bv[j] * cp[i][j][k];
+				du[k]  += dbu[i] * bv[j] * cp[i][j][k];
+				dv[k]  += bu[i] * dbv[j] * cp[i][j][k];
+			}
+		}
+	}
+
+	normal[0] = dv[1] * du[2] - dv[2] * du[1];
+	normal[1] = dv[2] * du[0] - dv[0] * du[2];
+	normal[2] = dv[0] * du[1] - dv[1] * du[0];
+}
+
+static void
+_revolved_patch(int profile, float cp[4][4][3])
+{
+	for(int i = 0; i < 4; i++) {
+		float r = profiles[profile][i][0];
+		float z = profiles[profile][i][1];
+		const float arc[4][2] = {
+			{ r, 0.0f }, { r, -kappa * r }, { kappa * r, -r }, { 0.0f, -r }
+		};
+		for(int j = 0; j < 4; j++) {
+			int a = profile_flip[profile] ? 3 - j : j;
+			cp[i][j][0] = arc[a][0];
+			cp[i][j][1] = arc[a][1];
+			cp[i][j][2] = z;
+		}
+	}
+}
+
+static void
+_build_level(MeshLevel *lvl, int grid, float size)
+{
+	const int side = grid + 1;
+	const float scale = 0.5f * size;
+
+	lvl->num_vertices = NUM_PATCHES * side * side;
+	lvl->num_indices  = NUM_PATCHES * grid * grid * 6;
+	lvl->vertices = (float*)mem_alloc(lvl->num_vertices * 6 * sizeof(float));
+	lvl->indices  = (unsigned short*)mem_alloc(lvl->num_indices * sizeof(unsigned short));
+
+	float *vert = lvl->vertices;
+	unsigned short *idx = lvl->indices;
+	int base = 0;
+
+	for(int p = 0; p < NUM_PATCHES; p++) {
+		float cp[4][4][3];
+		float rot_c = 1.0f, rot_s = 0.0f, mirror = 1.0f;
+
+		if(p < NUM_PROFILES * 4) {
+			// Quarter (p % 4), rotated by 90 degrees steps around Z
+			_revolved_patch(p / 4, cp);
+			const float cs[4][2] = { {1, 0}, {0, 1}, {-1, 0}, {0, -1} };
+			rot_c = cs[p % 4][0];
+			rot_s = cs[p % 4][1];
+		} else {
+			int h = p - NUM_PROFILES * 4;
+			for(int i = 0; i < 4; i++)
+				for(int j = 0; j < 4; j++)
+					for(int k = 0; k < 3; k++)
+						cp[i][j][k] = halves[h / 2][i][j][k];
+			mirror = (h & 1) ? -1.0f : 1.0f;
+		}
+
+		for(int i = 0; i < side; i++) {
+			for(int j = 0; j < side; j++) {
+				float u = (float)i / grid, v = (float)j / grid;
+				float pos[3], n[3];
+
+				_eval(cp, u, v, pos, n);
+				float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				if(len < 1e-6f) {
+					// Degenerate edge (a whole row collapsed to the
+					// lid or bottom center): sample slightly inside.
+					float tmp[3];
+					_eval(cp, u < 0.5f ? 0.001f : 0.999f, v, tmp, n);
+					len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				}
+				if(len > 0.0f) {
+					n[0] /= len; n[1] /= len; n[2] /= len;
+				}
+
+				// Rotate/mirror, then match glutSolidTeapot:
+				// glRotated(270, 1, 0, 0), scale by size / 2,
+				// and move down by 1.5 so the teapot is centered.
+				float px = rot_c * pos[0] - rot_s * pos[1];
+				float py = (rot_s * pos[0] + rot_c * pos[1]) * mirror;
+				float nx = rot_c * n[0] - rot_s * n[1];
+				float ny = (rot_s * n[0] + rot_c * n[1]) * mirror;
+
+				vert[0] = nx;
+				vert[1] = n[2];
+				vert[2] = -ny;
+				vert[3] = px * scale;
+				vert[4] = (pos[2] - 1.5f) * scale;
+				vert[5] = -py * scale;
+				vert += 6;
+			}
+		}
+
+		for(int i = 0; i < grid; i++) {
+			for(int j = 0; j < grid; j++) {
+				unsigned short a = (unsigned short)(base + i * side + j);
+				unsigned short b = (unsigned short)(a + side);
+				// Mirroring flips the winding
+				if(mirror > 0.0f) {
+					idx[0] = a; idx[1] = b;     idx[2] = a + 1;
+					idx[3] = b; idx[4] = b + 1; idx[5] = a + 1;
+				} else {
+					idx[0] = a; idx[1] = a + 1; idx[2] = b;
+					idx[3] = b; idx[4] = a + 1; idx[5] = b + 1;
+				}
+				idx += 6;
+			}
+		}
+		base += side * side;
+	}
+
+	lvl->min_pixels = 0.0f;
+}
+
+void
+teapot_build(MeshLod *mesh, float size)
+{
+	for(int l = 0; l < MESH_MAX_LEVELS; l++) {
+		_build_level(&mesh->levels[l], level_grid[l], size);
+		mesh->levels[l].min_pixels = level_pixels[l];
+	}
+	mesh->num_levels = MESH_MAX_LEVELS;
+	mesh->current = 0;
+	mesh->min_level = 0;
+
+	// Spout tip is the farthest point from the center
+	mesh->radius = 1.85f * size;
+}
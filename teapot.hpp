@@ -0,0 +1,10 @@
+#ifndef TEAPOT_HPP_INCLUDED
+#define TEAPOT_HPP_INCLUDED
+
+#include "mesh.hpp"
+
+// Builds the Utah teapot with the same orientation and size as
+// glutSolidTeapot, tessellating its Bezier patches once per level.
+void teapot_build(MeshLod *mesh, float size);
+
+#endif // TEAPOT_HPP_INCLUDED
@@ -0,0 +1,127 @@
+#include "telemetry.hpp"
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "metrics.hpp"
+#include "fps.hpp"
+#include "cull.hpp"
+#include "mesh.hpp"
+#include "memory.hpp"
+#include "profile.hpp"
+#include "render.hpp"
+#include "glstats.hpp"
+
+#define TELEMETRY_RESIDENCY_FRAMES 60 // Residency is a GL query
+
+static MetricsBlock *block = NULL;
+static const char   *block_name = NULL;
+
+static void
+_at_exit(void)
+{
+	telemetry_close();
+}
+
+bool
+telemetry_open(const char *name)
+{
+	telemetry_close();
+	block_name = name ? name : METRICS_DEFAULT_NAME;
+	block = metrics_map(block_name, true);
+	if(!block)
+		return false;
+
+	memset(block, 0, sizeof(MetricsBlock));
+	block->magic = METRICS_MAGIC;
+	block->version = METRICS_VERSION;
+	block->size = sizeof(MetricsBlock);
+#ifdef _WIN32
+	block->pid = GetCurrentProcessId();
+#else
+	block->pid = getpid();
+#endif
+
+	static bool registered = false;
+	if(!registered) {
+		atexit(_at_exit);
+		registered = true;
+	}
+	return true;
+}
+
+void
+telemetry_frame(void)
+{
+	if(!block)
+		return;
+
+	float frame_ms = 0.0f;
+	getFrameTimes(&frame_ms, 1);
+
+	CullStats cull;
+	GLStats gl;
+	MemStats mem;
+	const ProfileZoneStats *zones;
+	cull_get_stats(&cull);
+	glstats_last(&gl);
+	mem_last(&mem);
+	int num_zones = profile_last(&zones);
+	if(num_zones > METRICS_MAX_ZONES)
+		num_zones = METRICS_MAX_ZONES;
+
+	metrics_write_begin(block);
+
+	block->time = getElapsedTime();
+	block->frame++;
+	block->frame_ms = frame_ms;
+	block->fps = (float)getFps();
+	int bin = (int)frame_ms;
+	block->histogram[bin < METRICS_HISTOGRAM_BINS ? bin : METRICS_HISTOGRAM_BINS - 1]++;
+
+	block->draw_calls = gl.draw_calls;
+	block->gl_calls = gl.calls;
+	block->visible = cull.visible;
+	block->culled = cull.culled;
+	block->mesh_triangles = mesh_triangles_submitted();
+
+	block->allocs = mem.allocs;
+	block->alloc_bytes = (unsigned int)mem.bytes_allocated;
+	block->heap_bytes = (unsigned int)mem.bytes_live;
+	block->arena_bytes = (unsigned int)mem.arena_used;
+
+	if(block->frame % TELEMETRY_RESIDENCY_FRAMES == 1) {
+		TextureResidency residency;
+		texture_residency(&residency);
+		block->textures = residency.count;
+		block->textures_resident = residency.resident;
+		block->texture_bytes = (unsigned int)residency.bytes;
+		block->texture_bytes_resident = (unsigned int)residency.resident_bytes;
+	}
+
+	block->num_zones = num_zones;
+	for(int i = 0; i < num_zones; i++) {
+		MetricsZone &zone = block->zones[i];
+		strncpy(zone.name, zones[i].name, METRICS_ZONE_NAME - 1);
+		zone.name[METRICS_ZONE_NAME - 1] = '\0';
+		zone.ms = (float)zones[i].ms;
+		zone.calls = zones[i].calls;
+		zone.allocs = zones[i].allocs;
+		zone.alloc_bytes = (unsigned int)zones[i].bytes;
+	}
+
+	metrics_write_end(block);
+}
+
+void
+telemetry_close(void)
+{
+	if(block)
+		metrics_unmap(block, block_name, true);
+	block = NULL;
+}
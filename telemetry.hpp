@@ -0,0 +1,11 @@
+#ifndef TELEMETRY_HPP_INCLUDED
+#define TELEMETRY_HPP_INCLUDED
+
+// Publishes the engine's per-frame stats into a shared metrics block
+// (see metrics.hpp) for external monitoring.
+
+bool telemetry_open(const char *name); // NULL for METRICS_DEFAULT_NAME
+void telemetry_frame(void);            // After mem_frame/profile_frame
+void telemetry_close(void);
+
+#endif // TELEMETRY_HPP_INCLUDED
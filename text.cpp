@@ -0,0 +1,278 @@
+#include "text.hpp"
+#include <cstring>
+#include <GL/gl.h>
+
+#include "render.hpp"
+#include "glstats.hpp"
+
+#define ATLAS_SIZE    128
+#define ATLAS_COLUMNS 16
+#define FIRST_GLYPH   32
+#define NUM_GLYPHS    95
+#define SOLID_TEXEL   124 // Centre of an opaque 8x8 block in the corner
+
+// X11 misc-fixed 8x13 (public domain), rows top to bottom, MSB left
+static const unsigned char font[NUM_GLYPHS][TEXT_GLYPH_H] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+	{ 0x00, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x10, 0x00, 0x00, 0x00 }, // !
+	{ 0x00, 0x24, 0x24, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // "
+	{ 0x00, 0x00, 0x24, 0x24, 0x7e, 0x24, 0x7e, 0x24, 0x24, 0x00, 0x00, 0x00, 0x00 }, // #
+	{ 0x00, 0x10, 0x3c, 0x50, 0x50, 0x38, 0x14, 0x14, 0x78, 0x10, 0x00, 0x00, 0x00 }, // $
+	{ 0x00, 0x22, 0x52, 0x24, 0x08, 0x08, 0x10, 0x24, 0x2a, 0x44, 0x00, 0x00, 0x00 }, // %
+	{ 0x00, 0x00, 0x00, 0x30, 0x48, 0x48, 0x30, 0x4a, 0x44, 0x3a, 0x00, 0x00, 0x00 }, // &
+	{ 0x00, 0x38, 0x30, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '
+	{ 0x00, 0x04, 0x08, 0x08, 0x10, 0x10, 0x10, 0x08, 0x08, 0x04, 0x00, 0x00, 0x00 }, // (
+	{ 0x00, 0x20, 0x10, 0x10, 0x08, 0x08, 0x08, 0x10, 0x10, 0x20, 0x00, 0x00, 0x00 }, // )
+	{ 0x00, 0x00, 0x00, 0x24, 0x18, 0x7e, 0x18, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00 }, // *
+	{ 0x00, 0x00, 0x00, 0x10, 0x10, 0x7c, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00 }, // +
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x30, 0x40, 0x00, 0x00 }, // ,
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x7e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // -
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x38, 0x10, 0x00, 0x00 }, // .
+	{ 0x00, 0x02, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x80, 0x00, 0x00, 0x00 }, // /
+	{ 0x00, 0x18, 0x24, 0x42, 0x42, 0x42, 0x42, 0x42, 0x24, 0x18, 0x00, 0x00, 0x00 }, // 0
+	{ 0x00, 0x10, 0x30, 0x50, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7c, 0x00, 0x00, 0x00 }, // 1
+	{ 0x00, 0x3c, 0x42, 0x42, 0x02, 0x04, 0x18, 0x20, 0x40, 0x7e, 0x00, 0x00, 0x00 }, // 2
+	{ 0x00, 0x7e, 0x02, 0x04, 0x08, 0x1c, 0x02, 0x02, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // 3
+	{ 0x00, 0x04, 0x0c, 0x14, 0x24, 0x44, 0x44, 0x7e, 0x04, 0x04, 0x00, 0x00, 0x00 }, // 4
+	{ 0x00, 0x7e, 0x40, 0x40, 0x5c, 0x62, 0x02, 0x02, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // 5
+	{ 0x00, 0x1c, 0x20, 0x40, 0x40, 0x5c, 0x62, 0x42, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // 6
+	{ 0x00, 0x7e, 0x02, 0x04, 0x08, 0x08, 0x10, 0x10, 0x20, 0x20, 0x00, 0x00, 0x00 }, // 7
+	{ 0x00, 0x3c, 0x42, 0x42, 0x42, 0x3c, 0x42, 0x42, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // 8
+	{ 0x00, 0x3c, 0x42, 0x42, 0x46, 0x3a, 0x02, 0x02, 0x04, 0x38, 0x00, 0x00, 0x00 }, // 9
+	{ 0x00, 0x00, 0x00, 0x10, 0x38, 0x10, 0x00, 0x00, 0x10, 0x38, 0x10, 0x00, 0x00 }, // :
+	{ 0x00, 0x00, 0x00, 0x10, 0x38, 0x10, 0x00, 0x00, 0x38, 0x30, 0x40, 0x00, 0x00 }, // ;
+	{ 0x00, 0x02, 0x04, 0x08, 0x10, 0x20, 0x10, 0x08, 0x04, 0x02, 0x00, 0x00, 0x00 }, // <
+	{ 0x00, 0x00, 0x00, 0x00, 0x7e, 0x00, 0x00, 0x7e, 0x00, 0x00, 0x00, 0x00, 0x00 }, // =
+	{ 0x00, 0x40, 0x20, 0x10, 0x08, 0x04, 0x08, 0x10, 0x20, 0x40, 0x00, 0x00, 0x00 }, // >
+	{ 0x00, 0x3c, 0x42, 0x42, 0x02, 0x04, 0x08, 0x08, 0x00, 0x08, 0x00, 0x00, 0x00 }, // ?
+	{ 0x00, 0x3c, 0x42, 0x42, 0x4e, 0x52, 0x56, 0x4a, 0x40, 0x3c, 0x00, 0x00, 0x00 }, // @
+	{ 0x00, 0x18, 0x24, 0x42, 0x42, 0x42, 0x7e, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00 }, // A
+	{ 0x00, 0xfc, 0x42, 0x42, 0x42, 0x7c, 0x42, 0x42, 0x42, 0xfc, 0x00, 0x00, 0x00 }, // B
+	{ 0x00, 0x3c, 0x42, 0x40, 0x40, 0x40, 0x40, 0x40, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // C
+	{ 0x00, 0xfc, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0xfc, 0x00, 0x00, 0x00 }, // D
+	{ 0x00, 0x7e, 0x40, 0x40, 0x40, 0x78, 0x40, 0x40, 0x40, 0x7e, 0x00, 0x00, 0x00 }, // E
+	{ 0x00, 0x7e, 0x40, 0x40, 0x40, 0x78, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00 }, // F
+	{ 0x00, 0x3c, 0x42, 0x40, 0x40, 0x40, 0x4e, 0x42, 0x46, 0x3a, 0x00, 0x00, 0x00 }, // G
+	{ 0x00, 0x42, 0x42, 0x42, 0x42, 0x7e, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00 }, // H
+	{ 0x00, 0x7c, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7c, 0x00, 0x00, 0x00 }, // I
+	{ 0x00, 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x44, 0x38, 0x00, 0x00, 0x00 }, // J
+	{ 0x00, 0x42, 0x44, 0x48, 0x50, 0x60, 0x50, 0x48, 0x44, 0x42, 0x00, 0x00, 0x00 }, // K
+	{ 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x7e, 0x00, 0x00, 0x00 }, // L
+	{ 0x00, 0x82, 0x82, 0xc6, 0xaa, 0x92, 0x92, 0x82, 0x82, 0x82, 0x00, 0x00, 0x00 }, // M
+	{ 0x00, 0x42, 0x42, 0x62, 0x52, 0x4a, 0x46, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00 }, // N
+	{ 0x00, 0x3c, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // O
+	{ 0x00, 0x7c, 0x42, 0x42, 0x42, 0x7c, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00 }, // P
+	{ 0x00, 0x3c, 0x42, 0x42, 0x42, 0x42, 0x42, 0x52, 0x4a, 0x3c, 0x02, 0x00, 0x00 }, // Q
+	{ 0x00, 0x7c, 0x42, 0x42, 0x42, 0x7c, 0x50, 0x48, 0x44, 0x42, 0x00, 0x00, 0x00 }, // R
+	{ 0x00, 0x3c, 0x42, 0x40, 0x40, 0x3c, 0x02, 0x02, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // S
+	{ 0x00, 0xfe, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00 }, // T
+	{ 0x00, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // U
+	{ 0x00, 0x82, 0x82, 0x44, 0x44, 0x44, 0x28, 0x28, 0x28, 0x10, 0x00, 0x00, 0x00 }, // V
+	{ 0x00, 0x82, 0x82, 0x82, 0x82, 0x92, 0x92, 0x92, 0xaa, 0x44, 0x00, 0x00, 0x00 }, // W
+	{ 0x00, 0x82, 0x82, 0x44, 0x28, 0x10, 0x28, 0x44, 0x82, 0x82, 0x00, 0x00, 0x00 }, // X
+	{ 0x00, 0x82, 0x82, 0x44, 0x28, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00 }, // Y
+	{ 0x00, 0x7e, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x40, 0x7e, 0x00, 0x00, 0x00 }, // Z
+	{ 0x00, 0x3c, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x00, 0x00, 0x00 }, // [
+	{ 0x00, 0x80, 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x02, 0x00, 0x00, 0x00 }, // backslash
+	{ 0x00, 0x78, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x78, 0x00, 0x00, 0x00 }, // ]
+	{ 0x00, 0x10, 0x28, 0x44, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ^
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfe, 0x00, 0x00 }, // _
+	{ 0x00, 0x38, 0x18, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // `
+	{ 0x00, 0x00, 0x00, 0x00, 0x3c, 0x02, 0x3e, 0x42, 0x46, 0x3a, 0x00, 0x00, 0x00 }, // a
+	{ 0x00, 0x40, 0x40, 0x40, 0x5c, 0x62, 0x42, 0x42, 0x62, 0x5c, 0x00, 0x00, 0x00 }, // b
+	{ 0x00, 0x00, 0x00, 0x00, 0x3c, 0x42, 0x40, 0x40, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // c
+	{ 0x00, 0x02, 0x02, 0x02, 0x3a, 0x46, 0x42, 0x42, 0x46, 0x3a, 0x00, 0x00, 0x00 }, // d
+	{ 0x00, 0x00, 0x00, 0x00, 0x3c, 0x42, 0x7e, 0x40, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // e
+	{ 0x00, 0x1c, 0x22, 0x20, 0x20, 0x7c, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00 }, // f
+	{ 0x00, 0x00, 0x00, 0x00, 0x3a, 0x44, 0x44, 0x38, 0x40, 0x3c, 0x42, 0x3c, 0x00 }, // g
+	{ 0x00, 0x40, 0x40, 0x40, 0x5c, 0x62, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00 }, // h
+	{ 0x00, 0x00, 0x10, 0x00, 0x30, 0x10, 0x10, 0x10, 0x10, 0x7c, 0x00, 0x00, 0x00 }, // i
+	{ 0x00, 0x00, 0x04, 0x00, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x44, 0x44, 0x38, 0x00 }, // j
+	{ 0x00, 0x40, 0x40, 0x40, 0x44, 0x48, 0x70, 0x48, 0x44, 0x42, 0x00, 0x00, 0x00 }, // k
+	{ 0x00, 0x30, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7c, 0x00, 0x00, 0x00 }, // l
+	{ 0x00, 0x00, 0x00, 0x00, 0xec, 0x92, 0x92, 0x92, 0x92, 0x82, 0x00, 0x00, 0x00 }, // m
+	{ 0x00, 0x00, 0x00, 0x00, 0x5c, 0x62, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00 }, // n
+	{ 0x00, 0x00, 0x00, 0x00, 0x3c, 0x42, 0x42, 0x42, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // o
+	{ 0x00, 0x00, 0x00, 0x00, 0x5c, 0x62, 0x42, 0x62, 0x5c, 0x40, 0x40, 0x40, 0x00 }, // p
+	{ 0x00, 0x00, 0x00, 0x00, 0x3a, 0x46, 0x42, 0x46, 0x3a, 0x02, 0x02, 0x02, 0x00 }, // q
+	{ 0x00, 0x00, 0x00, 0x00, 0x5c, 0x22, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00 }, // r
+	{ 0x00, 0x00, 0x00, 0x00, 0x3c, 0x42, 0x30, 0x0c, 0x42, 0x3c, 0x00, 0x00, 0x00 }, // s
+	{ 0x00, 0x00, 0x20, 0x20, 0x7c, 0x20, 0x20, 0x20, 0x22, 0x1c, 0x00, 0x00, 0x00 }, // t
+	{ 0x00, 0x00, 0x00, 0x00, 0x44, 0x44, 0x44, 0x44, 0x44, 0x3a, 0x00, 0x00, 0x00 }, // u
+	{ 0x00, 0x00, 0x00, 0x00, 0x44, 0x44, 0x44, 0x28, 0x28, 0x10, 0x00, 0x00, 0x00 }, // v
+	{ 0x00, 0x00, 0x00, 0x00, 0x82, 0x82, 0x92, 0x92, 0xaa, 0x44, 0x00, 0x00, 0x00 }, // w
+	{ 0x00, 0x00, 0x00, 0x00, 0x42, 0x24, 0x18, 0x18, 0x24, 0x42, 0x00, 0x00, 0x00 }, // x
+	{ 0x00, 0x00, 0x00, 0x00, 0x42, 0x42, 0x42, 0x46, 0x3a, 0x02, 0x42, 0x3c, 0x00 }, // y
+	{ 0x00, 0x00, 0x00, 0x00, 0x7e, 0x04, 0x08, 0x10, 0x20, 0x7e, 0x00, 0x00, 0x00 }, // z
+	{ 0x00, 0x0e, 0x10, 0x10, 0x08, 0x30, 0x08, 0x10, 0x10, 0x0e, 0x00, 0x00, 0x00 }, // {
+	{ 0x00, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00 }, // |
+	{ 0x00, 0x70, 0x08, 0x08, 0x10, 0x0c, 0x10, 0x08, 0x08, 0x70, 0x00, 0x00, 0x00 }, // }
+	{ 0x00, 0x24, 0x54, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ~
+};
+
+static GLuint     atlas = 0;
+static TextVertex batch[TEXT_MAX_QUADS * 4];
+static int        num_quads = 0;
+static float      scale_x, scale_y; // Pixels to clip space
+
+void
+text_init(void)
+{
+	static unsigned char pixels[ATLAS_SIZE * ATLAS_SIZE];
+	memset(pixels, 0, sizeof(pixels));
+
+	for(int g = 0; g < NUM_GLYPHS; g++) {
+		int x0 = (g % ATLAS_COLUMNS) * TEXT_GLYPH_W;
+		int y0 = (g / ATLAS_COLUMNS) * TEXT_GLYPH_H;
+		for(int row = 0; row < TEXT_GLYPH_H; row++) {
+			for(int bit = 0; bit < TEXT_GLYPH_W; bit++) {
+				if(font[g][row] & (0x80 >> bit))
+					pixels[(y0 + row) * ATLAS_SIZE + x0 + bit] = 0xff;
+			}
+		}
+	}
+	for(int y = ATLAS_SIZE - 8; y < ATLAS_SIZE; y++)
+		memset(pixels + y * ATLAS_SIZE + ATLAS_SIZE - 8, 0xff, 8);
+
+	glGenTextures(1, &atlas);
+	glBindTexture(GL_TEXTURE_2D, atlas);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, ATLAS_SIZE, ATLAS_SIZE, 0,
+	             GL_ALPHA, GL_UNSIGNED_BYTE, pixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	track_texture(atlas, sizeof(pixels));
+}
+
+void
+text_dispose(void)
+{
+	if(atlas)
+		free_texture(atlas);
+	atlas = 0;
+}
+
+static void
+_vertex(TextVertex *v, float x, float y, float u, float t, unsigned int color)
+{
+	v->x = x;
+	v->y = y;
+	v->u = u;
+	v->v = t;
+	v->color[0] = (unsigned char)(color >> 24);
+	v->color[1] = (unsigned char)(color >> 16);
+	v->color[2] = (unsigned char)(color >> 8);
+	v->color[3] = (unsigned char)color;
+}
+
+static void
+_quad(TextVertex *v, float x, float y, float w, float h,
+      float u0, float v0, float u1, float v1, unsigned int color)
+{
+	_vertex(v + 0, x,     y,     u0, v0, color);
+	_vertex(v + 1, x + w, y,     u1, v0, color);
+	_vertex(v + 2, x + w, y + h, u1, v1, color);
+	_vertex(v + 3, x,     y + h, u0, v1, color);
+}
+
+void
+text_run_init(TextRun *run)
+{
+	run->string[0] = '\0';
+	run->x = run->y = 0.0f;
+	run->color = 0;
+	run->num_quads = 0;
+}
+
+void
+text_run_set(TextRun *run, float x, float y, unsigned int color,
+             const char *string)
+{
+	if(x == run->x && y == run->y && color == run->color
+	   && !strncmp(string, run->string, TEXT_RUN_CHARS))
+		return;
+
+	strncpy(run->string, string, TEXT_RUN_CHARS - 1);
+	run->string[TEXT_RUN_CHARS - 1] = '\0';
+	run->x = x;
+	run->y = y;
+	run->color = color;
+	run->num_quads = 0;
+
+	const float texel = 1.0f / ATLAS_SIZE;
+	float pen = x;
+	for(const char *c = run->string; *c; c++, pen += TEXT_GLYPH_W) {
+		int g = (unsigned char)*c - FIRST_GLYPH;
+		if(g <= 0 || g >= NUM_GLYPHS)
+			continue; // Spaces and anything outside ASCII
+		float u = (g % ATLAS_COLUMNS) * TEXT_GLYPH_W * texel;
+		float v = (g / ATLAS_COLUMNS) * TEXT_GLYPH_H * texel;
+		_quad(run->vertices + run->num_quads * 4, pen, y,
+		      TEXT_GLYPH_W, TEXT_GLYPH_H,
+		      u, v, u + TEXT_GLYPH_W * texel, v + TEXT_GLYPH_H * texel, color);
+		run->num_quads++;
+	}
+}
+
+void
+text_begin(void)
+{
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	scale_x = 2.0f / viewport[2];
+	scale_y = -2.0f / viewport[3];
+	num_quads = 0;
+}
+
+void
+text_add_run(const TextRun *run)
+{
+	int count = run->num_quads;
+	if(num_quads + count > TEXT_MAX_QUADS)
+		count = TEXT_MAX_QUADS - num_quads;
+	memcpy(batch + num_quads * 4, run->vertices, count * 4 * sizeof(TextVertex));
+	num_quads += count;
+}
+
+void
+text_add_rect(float x, float y, float w, float h, unsigned int color)
+{
+	if(num_quads >= TEXT_MAX_QUADS)
+		return;
+	float s = (SOLID_TEXEL + 0.5f) / ATLAS_SIZE;
+	_quad(batch + num_quads * 4, x, y, w, h, s, s, s, s, color);
+	num_quads++;
+}
+
+void
+text_flush(void)
+{
+	if(num_quads == 0)
+		return;
+
+	// Pixels to clip space; projection and modelview are identity
+	for(int i = 0; i < num_quads * 4; i++) {
+		batch[i].x = batch[i].x * scale_x - 1.0f;
+		batch[i].y = batch[i].y * scale_y + 1.0f;
+	}
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, atlas);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), &batch[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), &batch[0].u);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TextVertex), batch[0].color);
+	glDrawArrays(GL_QUADS, 0, num_quads * 4);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+	glEnable(GL_DEPTH_TEST);
+	num_quads = 0;
+}
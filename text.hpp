@@ -0,0 +1,44 @@
+#ifndef TEXT_HPP_INCLUDED
+#define TEXT_HPP_INCLUDED
+
+// Batched bitmap text. The ASCII range of an 8x13 fixed font is baked
+// into an alpha texture atlas once; a TextRun keeps the glyph quads of
+// its string and only rebuilds them when the string, position or
+// color change. Runs and solid rectangles added between text_begin
+// and text_flush go out in a single draw call. Coordinates are in
+// pixels from the top left corner of the viewport.
+
+#define TEXT_GLYPH_W   8
+#define TEXT_GLYPH_H   13
+#define TEXT_RUN_CHARS 96
+#define TEXT_MAX_QUADS 2048
+
+struct TextVertex
+{
+	float         x, y;
+	float         u, v;
+	unsigned char color[4];
+};
+
+struct TextRun
+{
+	char         string[TEXT_RUN_CHARS];
+	float        x, y;
+	unsigned int color; // 0xRRGGBBAA
+	int          num_quads;
+	TextVertex   vertices[TEXT_RUN_CHARS * 4];
+};
+
+void text_init(void); // Needs a GL context
+void text_dispose(void);
+
+void text_run_init(TextRun *run);
+void text_run_set(TextRun *run, float x, float y, unsigned int color,
+                  const char *string);
+
+void text_begin(void);
+void text_add_run(const TextRun *run);
+void text_add_rect(float x, float y, float w, float h, unsigned int color);
+void text_flush(void);
+
+#endif // TEXT_HPP_INCLUDED
@@ -0,0 +1,157 @@
+#include "tilemap.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <GL/gl.h>
+
+#include "memory.hpp"
+#include "glstats.hpp"
+
+#define FLOATS_PER_TILE 16 // Four corners of x, y, u, v
+
+void
+tilemap_init(Tilemap *map, int width, int height, float tile_size,
+             unsigned int texture, int columns, int rows)
+{
+	map->width     = width;
+	map->height    = height;
+	map->chunks_x  = (width + TILEMAP_CHUNK - 1) / TILEMAP_CHUNK;
+	map->chunks_y  = (height + TILEMAP_CHUNK - 1) / TILEMAP_CHUNK;
+	map->x         = 0.0f;
+	map->y         = 0.0f;
+	map->tile_size = tile_size;
+	map->texture   = texture;
+	map->columns   = columns;
+	map->rows      = rows;
+
+	int tiles_bytes = width * height * sizeof(unsigned short);
+	int chunks_bytes = map->chunks_x * map->chunks_y * sizeof(TilemapChunk);
+	map->tiles = (unsigned short*)mem_alloc(tiles_bytes);
+	map->chunks = (TilemapChunk*)mem_alloc(chunks_bytes);
+	memset(map->tiles, 0, tiles_bytes);
+	memset(map->chunks, 0, chunks_bytes);
+	for(int i = 0; i < map->chunks_x * map->chunks_y; i++)
+		map->chunks[i].dirty = true;
+
+	map->chunks_drawn = map->chunks_rebuilt = map->tiles_drawn = 0;
+}
+
+void
+tilemap_free(Tilemap *map)
+{
+	for(int i = 0; i < map->chunks_x * map->chunks_y; i++)
+		mem_free(map->chunks[i].vertices);
+	mem_free(map->chunks);
+	mem_free(map->tiles);
+	map->chunks = NULL;
+	map->tiles = NULL;
+	map->width = map->height = 0;
+	map->chunks_x = map->chunks_y = 0;
+}
+
+void
+tilemap_set(Tilemap *map, int x, int y, unsigned short tile)
+{
+	if(x < 0 || y < 0 || x >= map->width || y >= map->height)
+		return;
+	unsigned short *slot = &map->tiles[y * map->width + x];
+	if(*slot == tile)
+		return;
+	*slot = tile;
+	map->chunks[(y / TILEMAP_CHUNK) * map->chunks_x + x / TILEMAP_CHUNK].dirty = true;
+}
+
+unsigned short
+tilemap_get(const Tilemap *map, int x, int y)
+{
+	if(x < 0 || y < 0 || x >= map->width || y >= map->height)
+		return TILEMAP_EMPTY;
+	return map->tiles[y * map->width + x];
+}
+
+static void
+_build(Tilemap *map, int cx, int cy)
+{
+	TilemapChunk &chunk = map->chunks[cy * map->chunks_x + cx];
+	if(chunk.vertices == NULL) {
+		chunk.vertices = (float*)mem_alloc(TILEMAP_CHUNK * TILEMAP_CHUNK
+		                                * FLOATS_PER_TILE * sizeof(float));
+	}
+
+	float cell_w = 1.0f / map->columns;
+	float cell_h = 1.0f / map->rows;
+	float size = map->tile_size;
+	float *v = chunk.vertices;
+	int num_tiles = 0;
+
+	for(int ty = cy * TILEMAP_CHUNK; ty < (cy + 1) * TILEMAP_CHUNK && ty < map->height; ty++) {
+		for(int tx = cx * TILEMAP_CHUNK; tx < (cx + 1) * TILEMAP_CHUNK && tx < map->width; tx++) {
+			int tile = map->tiles[ty * map->width + tx];
+			if(tile == TILEMAP_EMPTY)
+				continue;
+
+			float u = ((tile - 1) % map->columns) * cell_w;
+			float t = ((tile - 1) / map->columns % map->rows) * cell_h;
+			float left = map->x + tx * size, top = map->y - ty * size;
+			const float corners[FLOATS_PER_TILE] = {
+				left,        top,        u,          t,
+				left + size, top,        u + cell_w, t,
+				left + size, top - size, u + cell_w, t + cell_h,
+				left,        top - size, u,          t + cell_h,
+			};
+			memcpy(v, corners, sizeof(corners));
+			v += FLOATS_PER_TILE;
+			num_tiles++;
+		}
+	}
+
+	chunk.num_tiles = num_tiles;
+	chunk.dirty = false;
+	map->chunks_rebuilt++;
+}
+
+void
+tilemap_draw(Tilemap *map, float min_x, float min_y, float max_x, float max_y)
+{
+	map->chunks_drawn = map->chunks_rebuilt = map->tiles_drawn = 0;
+
+	// View to the range of chunks it overlaps; edges that only touch
+	// the next chunk do not pull it in
+	float chunk_size = map->tile_size * TILEMAP_CHUNK;
+	int first_x = (int)floorf((min_x - map->x) / chunk_size);
+	int last_x  = (int)ceilf((max_x - map->x) / chunk_size) - 1;
+	int first_y = (int)floorf((map->y - max_y) / chunk_size);
+	int last_y  = (int)ceilf((map->y - min_y) / chunk_size) - 1;
+	if(first_x < 0) first_x = 0;
+	if(first_y < 0) first_y = 0;
+	if(last_x >= map->chunks_x) last_x = map->chunks_x - 1;
+	if(last_y >= map->chunks_y) last_y = map->chunks_y - 1;
+	if(first_x > last_x || first_y > last_y)
+		return;
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, map->texture);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	for(int cy = first_y; cy <= last_y; cy++) {
+		for(int cx = first_x; cx <= last_x; cx++) {
+			TilemapChunk &chunk = map->chunks[cy * map->chunks_x + cx];
+			if(chunk.dirty)
+				_build(map, cx, cy);
+			if(chunk.num_tiles == 0)
+				continue;
+
+			glVertexPointer(2, GL_FLOAT, 4 * sizeof(float), chunk.vertices);
+			glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(float), chunk.vertices + 2);
+			glDrawArrays(GL_QUADS, 0, chunk.num_tiles * 4);
+			map->chunks_drawn++;
+			map->tiles_drawn += chunk.num_tiles;
+		}
+	}
+
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+}
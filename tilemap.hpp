@@ -0,0 +1,48 @@
+#ifndef TILEMAP_HPP_INCLUDED
+#define TILEMAP_HPP_INCLUDED
+
+// Tile maps drawn from a tileset texture cut into a grid. The map is
+// split into TILEMAP_CHUNK square chunks; each chunk keeps the quads
+// of its non-empty tiles in a vertex array that is only rebuilt when
+// one of its tiles changes, and only chunks overlapping the view are
+// visited, so the cost follows the view and not the size of the map.
+//
+// Tile 0 is empty, tile n is cell n - 1 of the tileset, row by row.
+// Map rows go down from the top left corner at (x, y).
+
+#define TILEMAP_CHUNK 16
+#define TILEMAP_EMPTY 0
+
+struct TilemapChunk
+{
+	float *vertices;  // x, y, u, v per corner, built on first draw
+	int    num_tiles;
+	bool   dirty;
+};
+
+struct Tilemap
+{
+	int             width, height; // In tiles
+	int             chunks_x, chunks_y;
+	float           x, y;          // Top left corner
+	float           tile_size;
+	unsigned int    texture;
+	int             columns, rows; // Tileset grid
+	unsigned short *tiles;
+	TilemapChunk   *chunks;
+
+	// Last draw
+	int             chunks_drawn;
+	int             chunks_rebuilt;
+	int             tiles_drawn;
+};
+
+void           tilemap_init(Tilemap *map, int width, int height, float tile_size,
+                            unsigned int texture, int columns, int rows);
+void           tilemap_free(Tilemap *map);
+void           tilemap_set(Tilemap *map, int x, int y, unsigned short tile);
+unsigned short tilemap_get(const Tilemap *map, int x, int y);
+void           tilemap_draw(Tilemap *map, float min_x, float min_y,
+                            float max_x, float max_y); // View, in map units
+
+#endif // TILEMAP_HPP_INCLUDED
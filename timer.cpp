@@ -0,0 +1,218 @@
+#include "timer.hpp"
+#include <cstddef>
+
+#define TIMER_INDEX_BITS 10 // Enough for TIMER_MAX
+#define TIMER_INDEX_MASK ((1 << TIMER_INDEX_BITS) - 1)
+
+enum TimerState
+{
+	TIMER_FREE,
+	TIMER_WHEEL,
+	TIMER_DUE,   // Taken off the wheel, about to fire
+	TIMER_FIRING
+};
+
+struct Timer
+{
+	long          expiry; // In ticks (ms)
+	double        period;
+	TimerFunc     func;
+	void         *data;
+	int           prev, next; // Slot list, or free list through next
+	unsigned int  generation;
+	TimerState    state;
+};
+
+static Timer timers[TIMER_MAX];
+static int   slots[TIMER_SLOTS];
+static int   free_list = TIMER_NONE;
+static int   num_timers = 0;
+static long  now_tick = 0;
+static int   due[TIMER_MAX];
+static bool  ready = false;
+
+static void
+_init(void)
+{
+	for(int i = 0; i < TIMER_SLOTS; i++)
+		slots[i] = TIMER_NONE;
+	for(int i = 0; i < TIMER_MAX; i++) {
+		timers[i].state = TIMER_FREE;
+		timers[i].generation = 0;
+		timers[i].next = (i + 1 < TIMER_MAX) ? i + 1 : TIMER_NONE;
+	}
+	free_list = 0;
+	ready = true;
+}
+
+static int
+_index(int timer)
+{
+	int index = timer & TIMER_INDEX_MASK;
+	if(timer < 0 || index >= TIMER_MAX
+	   || timers[index].generation != ((unsigned int)timer >> TIMER_INDEX_BITS)
+	   || timers[index].state == TIMER_FREE)
+		return TIMER_NONE;
+	return index;
+}
+
+static void
+_link(int index)
+{
+	Timer &t = timers[index];
+	int *head = &slots[t.expiry & (TIMER_SLOTS - 1)];
+	t.state = TIMER_WHEEL;
+	t.prev = TIMER_NONE;
+	t.next = *head;
+	if(*head != TIMER_NONE)
+		timers[*head].prev = index;
+	*head = index;
+}
+
+static void
+_unlink(int index)
+{
+	Timer &t = timers[index];
+	if(t.prev != TIMER_NONE)
+		timers[t.prev].next = t.next;
+	else slots[t.expiry & (TIMER_SLOTS - 1)] = t.next;
+	if(t.next != TIMER_NONE)
+		timers[t.next].prev = t.prev;
+}
+
+static void
+_release(int index)
+{
+	Timer &t = timers[index];
+	t.state = TIMER_FREE;
+	t.generation = (t.generation + 1) & (0x7fffffff >> TIMER_INDEX_BITS);
+	t.next = free_list;
+	free_list = index;
+	num_timers--;
+}
+
+static long
+_ticks(double ms)
+{
+	long ticks = (long)(ms + 0.5);
+	return ticks > 0 ? ticks : 0;
+}
+
+int
+timer_add(double delay_ms, double period_ms, TimerFunc func, void *data)
+{
+	if(!ready)
+		_init();
+	if(free_list == TIMER_NONE)
+		return TIMER_NONE;
+
+	int index = free_list;
+	Timer &t = timers[index];
+	free_list = t.next;
+	num_timers++;
+
+	// At least one tick, so it fires on a later advance
+	long delay = _ticks(delay_ms);
+	t.expiry = now_tick + (delay > 0 ? delay : 1);
+	t.period = period_ms;
+	t.func = func;
+	t.data = data;
+	_link(index);
+
+	return (int)(t.generation << TIMER_INDEX_BITS) | index;
+}
+
+void
+timer_cancel(int timer)
+{
+	int index = _index(timer);
+	if(index == TIMER_NONE)
+		return;
+
+	switch(timers[index].state) {
+	case TIMER_FIRING:
+		// Released once its callback returns
+		timers[index].period = 0.0;
+		break;
+	case TIMER_WHEEL:
+		_unlink(index);
+		// Fall through
+	default:
+		_release(index);
+		break;
+	}
+}
+
+bool
+timer_pending(int timer)
+{
+	return _index(timer) != TIMER_NONE;
+}
+
+static void
+_fire(int index)
+{
+	Timer &t = timers[index];
+	t.state = TIMER_FIRING;
+	t.func(t.data);
+
+	if(t.period > 0.0) {
+		long period = _ticks(t.period);
+		if(period < 1)
+			period = 1;
+		t.expiry += period;
+		if(t.expiry <= now_tick)
+			t.expiry = now_tick + period;
+		_link(index);
+	} else {
+		_release(index);
+	}
+}
+
+void
+timer_advance(double now_ms)
+{
+	if(!ready)
+		_init();
+
+	long target = _ticks(now_ms);
+	if(target <= now_tick)
+		return;
+
+	// Past a full turn every slot gets visited once anyway
+	long from = now_tick + 1;
+	if(target - from >= TIMER_SLOTS)
+		from = target - TIMER_SLOTS + 1;
+
+	now_tick = target;
+	for(long tick = from; tick <= target; tick++) {
+		// Take the due timers off first: callbacks may change the slot
+		int num_due = 0;
+		for(int i = slots[tick & (TIMER_SLOTS - 1)]; i != TIMER_NONE; i = timers[i].next) {
+			if(timers[i].expiry <= target)
+				due[num_due++] = i;
+		}
+		for(int i = 0; i < num_due; i++) {
+			_unlink(due[i]);
+			timers[due[i]].state = TIMER_DUE;
+		}
+
+		// Cancelled or reused by an earlier callback if no longer due
+		for(int i = 0; i < num_due; i++) {
+			if(timers[due[i]].state == TIMER_DUE)
+				_fire(due[i]);
+		}
+	}
+}
+
+double
+timer_now(void)
+{
+	return (double)now_tick;
+}
+
+int
+timer_count(void)
+{
+	return num_timers;
+}
@@ -0,0 +1,27 @@
+#ifndef TIMER_HPP_INCLUDED
+#define TIMER_HPP_INCLUDED
+
+// Hashed timer wheel. Timers hash into TIMER_SLOTS buckets of one
+// millisecond by expiry; timer_advance, called once per frame with
+// the frame clock, visits only the buckets the clock moved over and
+// fires whatever is due in them. Adding and cancelling are O(1).
+//
+// Callbacks run inside timer_advance and may add or cancel timers,
+// including their own. A periodic timer that fell behind fires once
+// and is rescheduled a full period from the current clock.
+
+#define TIMER_SLOTS 256 // Power of two
+#define TIMER_MAX   1024
+#define TIMER_NONE  -1
+
+typedef void (*TimerFunc)(void *data);
+
+int    timer_add(double delay_ms, double period_ms, // Period 0: one-shot
+                 TimerFunc func, void *data);
+void   timer_cancel(int timer);
+bool   timer_pending(int timer);
+void   timer_advance(double now_ms);
+double timer_now(void);
+int    timer_count(void);
+
+#endif // TIMER_HPP_INCLUDED